@@ -237,12 +237,81 @@ void test_script_spawn(lethe::ScriptContext *ctx)
 	static_cast<direct_native_class *>(sptr.Get())->exec_test(*ctx);
 }
 
-int main()
+int g_failed_checks = 0;
+
+void native_check(lethe::Stack &stk)
+{
+	if (!stk.GetBool(0))
+	{
+		xprintf("check failed\n");
+		g_failed_checks++;
+	}
+}
+
+// runs self-checking test scripts (see tests/readme.txt) in JIT and interpreter mode
+// returns number of failed runs
+int run_script_tests(int argc, char **argv)
+{
+	// natives available to test scripts
+	const char *prelude = R"src(
+		native __format void printf(string fmt, ...);
+		native void check(bool expr);
+	)src";
+
+	int failed = 0;
+
+	for (int i=1; i<argc; i++)
+	{
+		for (auto mode : {lethe::ENGINE_JIT, lethe::ENGINE_DEBUG_NOBREAK})
+		{
+			lethe::ScriptEngine engine(mode);
+
+			engine.onError = [](const lethe::String &msg, const lethe::TokenLocation &loc)
+			{
+				xprintf("err [%d:%d %s] %s\n", loc.line, loc.column, loc.file.Ansi(), msg.Ansi());
+			};
+
+			engine.BindNativeFunction("printf", native_printf);
+			engine.BindNativeFunction("check", native_check);
+
+			bool ok = engine.CompileBuffer(prelude, "prelude");
+			ok = ok && engine.CompileFile(argv[i]) && engine.Link();
+
+			// scripts check themselves when their globals are constructed
+			if (ok)
+			{
+				g_failed_checks = 0;
+				auto ctx = engine.CreateContext();
+
+				ctx->onRuntimeError = [&ok](const char *msg)
+				{
+					xprintf("runtime error: %s\n", msg);
+					ok = false;
+				};
+
+				ctx->RunConstructors();
+				ctx->RunDestructors();
+				ok = ok && !g_failed_checks;
+			}
+
+			xprintf("%s [%s]: %s\n", argv[i], mode == lethe::ENGINE_JIT ? "jit" : "interpreter", ok ? "ok" : "FAILED");
+			failed += !ok;
+		}
+	}
+
+	return failed;
+}
+
+int main(int argc, char **argv)
 {
 	// we're using init scope guard here, otherwise call lethe::Init() and lethe::Done()
 	// for static init/done
 	lethe::InitGuard init;
 
+	// sample tests/*.script runs test scripts instead
+	if (argc > 1)
+		return run_script_tests(argc, argv);
+
 	lethe::ScriptEngine engine(test_debug_server ? lethe::ENGINE_DEBUG : lethe::ENGINE_JIT);
 
 	engine.EnableInlineExpansion(!test_debug_server);
@@ -1,46 +1,388 @@
 #include "../Sys/Types.h"
 #include "../Sys/Assert.h"
+#include "../Sys/Likely.h"
 #include "../Memory/AlignedAlloc.h"
+#include "../Memory/Memory.h"
+#include "../Memory/Heap.h"
+#include "../Math/Templates.h"
 #include "../Thread/Atomic.h"
 #include "ObjectHeap.h"
 
 namespace lethe
 {
 
+// ObjectHeap::ThreadCache
+
+struct ObjectHeap::ThreadCache
+{
+	ObjectHeap *heap = nullptr;
+	ThreadCache *prev = nullptr;
+	ThreadCache *next = nullptr;
+	// only written by owning thread; may go negative if blocks are freed by other threads
+	AtomicLong count = 0;
+	Int sizes[POOL_SIZE_CLASSES] = {};
+	void *blocks[POOL_SIZE_CLASSES][THREAD_CACHE_SIZE];
+#if LETHE_DEBUG
+	// set while owning thread uses the cache, other threads may only flush idle caches
+	AtomicInt busy = 0;
+#endif
+
+	~ThreadCache()
+	{
+		if (heap)
+			heap->DetachCache(*this);
+	}
+};
+
+#if LETHE_DEBUG
+// debug check: marks thread cache as used by owning thread
+struct CacheUseScope
+{
+	AtomicInt &busy;
+
+	explicit CacheUseScope(AtomicInt &nbusy)
+		: busy(nbusy)
+	{
+		Atomic::Increment(busy);
+	}
+
+	~CacheUseScope()
+	{
+		Atomic::Decrement(busy);
+	}
+};
+
+#	define LETHE_CACHE_USE(tc) CacheUseScope cacheUse_((tc).busy)
+#else
+#	define LETHE_CACHE_USE(tc) (void)0
+#endif
+
 // ObjectHeap
 
 LETHE_SINGLETON_INSTANCE(ObjectHeap)
 
+ObjectHeap::ThreadCache &ObjectHeap::GetThreadCache()
+{
+	static thread_local ThreadCache tc;
+
+	if (LETHE_UNLIKELY(tc.heap != this))
+		AttachCache(tc);
+
+	return tc;
+}
+
+void ObjectHeap::AttachCache(ThreadCache &tc)
+{
+	LETHE_ASSERT(!tc.heap);
+
+	SpinMutexLock _(cacheMutex);
+	tc.heap = this;
+	LETHE_DLIST_ADD(&tc, cacheHead, cacheTail, prev, next);
+}
+
+void ObjectHeap::DetachCache(ThreadCache &tc)
+{
+	SpinMutexLock _(cacheMutex);
+
+	FlushCache(tc);
+	detachedCount += Atomic::Load(tc.count);
+	tc.count = 0;
+	tc.heap = nullptr;
+	LETHE_DLIST_UNLINK(&tc, cacheHead, cacheTail, prev, next);
+}
+
+void ObjectHeap::FlushCache(ThreadCache &tc)
+{
+	for (Int i=0; i<POOL_SIZE_CLASSES; i++)
+	{
+		if (!tc.sizes[i])
+			continue;
+
+		pools[i]->FreeBatch(tc.blocks[i], tc.sizes[i]);
+		tc.sizes[i] = 0;
+	}
+}
+
+Int ObjectHeap::GetSizeClass(size_t size, size_t align)
+{
+	if (align > ObjectPool::MAX_ALIGN || size > POOL_MAX_SIZE)
+		return -1;
+
+	return Int((size + sizeof(UIntPtr) + ObjectPool::MAX_ALIGN-1) / ObjectPool::MAX_ALIGN - 1);
+}
+
+ObjectPool *ObjectHeap::FindGroupPool(Int sizeClass, UInt groupKey)
+{
+	ULong key = ((ULong)groupKey << 8) | (ULong)sizeClass;
+
+	SpinMutexLock _(groupMutex);
+
+	auto it = groupPools.Find(key);
+
+	if (it != groupPools.End())
+		return it->value;
+
+	auto *res = new ObjectPool(pools[sizeClass]->GetBlockSize(), groupKey);
+	groupPools[key] = res;
+	return res;
+}
+
+void *ObjectHeap::AllocBlock(ThreadCache &tc, size_t size, size_t align, UInt groupKey)
+{
+	if (!pooling)
+		return ObjectAllocator.CallAlloc(size, align, groupKey);
+
+	auto idx = GetSizeClass(size, align);
+
+	if (idx < 0)
+		return ObjectPool::AllocLarge(size, align);
+
+	if (poolPerClass && groupKey)
+		return FindGroupPool(idx, groupKey)->Alloc();
+
+	auto &n = tc.sizes[idx];
+
+	if (LETHE_UNLIKELY(!n))
+		n = pools[idx]->AllocBatch(tc.blocks[idx], THREAD_CACHE_SIZE/2);
+
+	return n ? tc.blocks[idx][--n] : nullptr;
+}
+
 // allocate/deallocate
 void *ObjectHeap::Alloc(size_t size, size_t align, UInt groupKey)
 {
-	void *res = ObjectAllocator.CallAlloc(size, align, groupKey);
-	UInt inc = Atomic::Increment(count);
-	(void)inc;
-	LETHE_ASSERT(inc);
+	auto &tc = GetThreadCache();
+	LETHE_CACHE_USE(tc);
+	void *res = AllocBlock(tc, size, align, groupKey);
+	Atomic::Store(tc.count, tc.count + 1);
 
 	return res;
 }
 
 void ObjectHeap::Dealloc(void *ptr)
 {
-	ObjectAllocator.CallFree(ptr);
-	Atomic::Decrement(count);
+	auto &tc = GetThreadCache();
+	LETHE_CACHE_USE(tc);
+	Atomic::Store(tc.count, tc.count - 1);
+
+	if (!pooling || !ptr)
+	{
+		ObjectAllocator.CallFree(ptr);
+		return;
+	}
+
+	if (!ObjectPool::IsPooled(ptr))
+	{
+		// foreign memory is never ours to free
+		LETHE_ASSERT(!ObjectPool::IsForeign(ptr) && "freeing foreign block (arena memory)!");
+
+		if (!ObjectPool::IsForeign(ptr))
+			ObjectPool::FreeLarge(ptr);
+
+		return;
+	}
+
+	auto *pool = ObjectPool::GetPool(ptr);
+	auto idx = GetSizeClass(pool->GetBlockSize(), 1);
+
+	if (pools[idx] != pool)
+	{
+		ObjectPool::Free(ptr);
+		return;
+	}
+
+	auto &n = tc.sizes[idx];
+
+	if (LETHE_UNLIKELY(n == THREAD_CACHE_SIZE))
+	{
+		// return older half, keep recently freed blocks
+		const Int half = THREAD_CACHE_SIZE/2;
+		pool->FreeBatch(tc.blocks[idx], half);
+		MemCpy(tc.blocks[idx], tc.blocks[idx] + half, half*sizeof(void *));
+		n = half;
+	}
+
+	tc.blocks[idx][n++] = ptr;
 }
 
 void *ObjectHeap::Realloc(void *ptr, size_t newSize, size_t align, UInt groupKey)
 {
 	LETHE_ASSERT(newSize > 0);
-	return ObjectAllocator.CallRealloc(ptr, newSize, align, groupKey);
+
+	// counted like any other allocation
+	if (!ptr)
+		return Alloc(newSize, align, groupKey);
+
+	if (!pooling)
+		return ObjectAllocator.CallRealloc(ptr, newSize, align, groupKey);
+
+	// size of foreign blocks (arena memory) is unknown and they can't be freed: fail like C realloc, ptr stays valid
+	if (ObjectPool::IsForeign(ptr))
+	{
+		LETHE_ASSERT(false && "reallocating foreign block (arena memory)!");
+		return nullptr;
+	}
+
+	const bool pooled = ObjectPool::IsPooled(ptr);
+	const size_t oldSize = pooled ? ObjectPool::GetBlockSize(ptr) : ObjectPool::GetLargeSize(ptr);
+
+	// in-place if it still fits the slot
+	if (pooled && align <= ObjectPool::MAX_ALIGN && newSize <= oldSize)
+		return ptr;
+
+	auto *res = Alloc(newSize, align, groupKey);
+
+	if (!res)
+		return nullptr;
+
+	MemCpy(res, ptr, Min(oldSize, newSize));
+	Dealloc(ptr);
+
+	return res;
+}
+
+size_t ObjectHeap::GetCount() const
+{
+	SpinMutexLock _(cacheMutex);
+
+	Long res = detachedCount;
+
+	for (auto *it = cacheHead; it; it = it->next)
+		res += Atomic::Load(it->count);
+
+	LETHE_ASSERT(res >= 0);
+	return (size_t)res;
+}
+
+bool ObjectHeap::SetPooling(bool enable, bool perClass)
+{
+	if (GetCount())
+		return false;
+
+	ClearPools();
+	pooling = enable;
+	poolPerClass = perClass;
+	CreatePools();
+	return true;
+}
+
+size_t ObjectHeap::GetBlockSize(const void *ptr, size_t size) const
+{
+	if (!pooling || !ptr || !ObjectPool::IsPooled(ptr))
+		return size;
+
+	return ObjectPool::GetBlockSize(ptr);
 }
 
-ObjectHeap::ObjectHeap() : count(0)
+size_t ObjectHeap::Trim(void *ptr, size_t keep)
 {
+	// size of non-pooled blocks is only known for our large blocks
+	if (!pooling || !ptr || ObjectPool::IsPooled(ptr))
+		return 0;
+
+	auto size = ObjectPool::GetLargeSize(ptr);
+
+	if (size <= keep)
+		return 0;
+
+	return Heap::DiscardPages(static_cast<Byte *>(ptr) + keep, size - keep);
+}
+
+void ObjectHeap::GetPoolStats(Array<ObjectPool::Stats> &stats) const
+{
+	stats.Clear();
+
+	ObjectPool::Stats tmp;
+
+	for (auto *it : pools)
+	{
+		if (!it)
+			continue;
+
+		it->GetStats(tmp);
+
+		if (tmp.allocs)
+			stats.Add(tmp);
+	}
+
+	SpinMutexLock _(groupMutex);
+
+	for (const auto &it : groupPools)
+	{
+		it.value->GetStats(tmp);
+
+		if (tmp.allocs)
+			stats.Add(tmp);
+	}
+}
+
+void ObjectHeap::CreatePools()
+{
+	if (!pooling)
+		return;
+
+	for (Int i=0; i<POOL_SIZE_CLASSES; i++)
+		pools[i] = new ObjectPool((size_t)(i+1)*ObjectPool::MAX_ALIGN - sizeof(UIntPtr));
+}
+
+void ObjectHeap::ClearPools()
+{
+	{
+		// note: threads must not allocate at this point
+		SpinMutexLock _(cacheMutex);
+
+		for (auto *it = cacheHead; it; it = it->next)
+		{
+#if LETHE_DEBUG
+			LETHE_ASSERT(!Atomic::Load(it->busy) && "flushing thread cache in use!");
+#endif
+			FlushCache(*it);
+		}
+	}
+
+	for (auto &it : pools)
+	{
+		delete it;
+		it = nullptr;
+	}
+
+	for (auto &it : groupPools)
+		delete it.value;
+
+	groupPools.Clear();
+}
+
+ObjectHeap::ObjectHeap()
+	: poolPerClass(false)
+	, cacheHead(nullptr)
+	, cacheTail(nullptr)
+	, detachedCount(0)
+{
+#if LETHE_DISABLE_FANCY_ALLOCATORS
+	pooling = false;
+#else
+	pooling = !ObjectAllocator.Alloc;
+#endif
+
+	for (auto &it : pools)
+		it = nullptr;
+
+	CreatePools();
 }
 
 ObjectHeap::~ObjectHeap()
 {
-	LETHE_ASSERT(!count && "Object heap contains live blocks!");
+	LETHE_ASSERT(!GetCount() && "Object heap contains live blocks!");
+
+	ClearPools();
+
+	// thread caches outliving the heap must not touch it
+	while (cacheHead)
+	{
+		auto *tc = cacheHead;
+		tc->heap = nullptr;
+		LETHE_DLIST_UNLINK(tc, cacheHead, cacheTail, prev, next);
+	}
 }
 
 }
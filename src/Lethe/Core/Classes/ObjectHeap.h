@@ -3,28 +3,85 @@
 #include "../Sys/Types.h"
 #include "../Sys/Singleton.h"
 #include "../Thread/Lock.h"
+#include "../Collect/Array.h"
+#include "../Collect/HashMap.h"
+#include "../Memory/ObjectPool.h"
 
 namespace lethe
 {
 
 class LETHE_API ObjectHeap
 {
-	AtomicUInt count;		// object count (FIXME: can't have more than 4 billion objects)
 	LETHE_SINGLETON(ObjectHeap)
 public:
 	ObjectHeap();
 	~ObjectHeap();
 
+	// size classes are multiples of 16 bytes (including block header)
+	static const Int POOL_SIZE_CLASSES = 32;
+	static const size_t POOL_MAX_SIZE = POOL_SIZE_CLASSES*ObjectPool::MAX_ALIGN - sizeof(UIntPtr);
+	// blocks per size class kept by each thread; half is moved from/to the pool at once
+	static const Int THREAD_CACHE_SIZE = 32;
+
 	// allocate/deallocate/reallocate
 	void *Alloc(size_t size, size_t align = 8, UInt groupKey = 0);
 	void Dealloc(void *ptr);
+	// pooled: contents are copied and old block freed if it can't grow in place (like C realloc)
+	// returns null for foreign blocks (see ObjectPool::MarkForeign), ptr is left untouched
+	// pooling disabled: forwards to ObjectAllocator (see CustomAllocator::Realloc)
 	void *Realloc(void *ptr, size_t newSize, size_t align = 8, UInt groupKey = 0);
 
 	// get number of allocated blocks
-	inline size_t GetCount() const
-	{
-		return (size_t)count;
-	}
+	// sums per-thread counters, so this is relatively slow
+	size_t GetCount() const;
+
+	// small blocks go to size-class pools, slabs come from ObjectAllocator
+	// on by default unless a custom ObjectAllocator is installed
+	// perClass: separate pools for each groupKey (class name hash)
+	// can only be changed while there are no live blocks, returns false otherwise
+	// other threads must not allocate meanwhile (their caches are flushed; asserted in debug builds)
+	bool SetPooling(bool enable, bool perClass = false);
+	inline bool IsPooling() const {return pooling;}
+
+	// actual size of block at ptr allocated with size bytes, including size class rounding
+	size_t GetBlockSize(const void *ptr, size_t size) const;
+
+	// release physical memory of block at ptr past first keep bytes; block stays allocated at the same address
+	// used for destroyed objects kept alive only by weak references; only large blocks are trimmed
+	// returns number of bytes released
+	size_t Trim(void *ptr, size_t keep);
+
+	// gather stats for all pools that have been used
+	void GetPoolStats(Array<ObjectPool::Stats> &stats) const;
+
+private:
+	struct ThreadCache;
+
+	ThreadCache &GetThreadCache();
+	void AttachCache(ThreadCache &tc);
+	void DetachCache(ThreadCache &tc);
+	void FlushCache(ThreadCache &tc);
+
+	// returns -1 if block doesn't fit any size class
+	static Int GetSizeClass(size_t size, size_t align);
+	ObjectPool *FindGroupPool(Int sizeClass, UInt groupKey);
+	// allocate without counting
+	void *AllocBlock(ThreadCache &tc, size_t size, size_t align, UInt groupKey);
+	void CreatePools();
+	void ClearPools();
+
+	bool pooling;
+	bool poolPerClass;
+	ObjectPool *pools[POOL_SIZE_CLASSES];
+	// per class pools
+	mutable SpinMutex groupMutex;
+	HashMap<ULong, ObjectPool *> groupPools;
+	// thread caches, each holds its own object count
+	mutable SpinMutex cacheMutex;
+	ThreadCache *cacheHead;
+	ThreadCache *cacheTail;
+	// object count of threads that have exited
+	Long detachedCount;
 };
 
 }
@@ -5,6 +5,87 @@
 namespace lethe
 {
 
+// TokenFileTable
+
+LETHE_SINGLETON_INSTANCE(TokenFileTable)
+
+TokenFileTable::TokenFileTable()
+	: count(1)
+{
+	MemSet(chunks, 0, sizeof(chunks));
+	// index 0 is empty string
+	chunks[0] = new String[CHUNK_SIZE];
+}
+
+TokenFileTable::~TokenFileTable()
+{
+	for (auto *it : chunks)
+		delete[] it;
+}
+
+Int TokenFileTable::Add(const char *str)
+{
+	if (!str || !*str)
+		return 0;
+
+	MutexLock lock(mutex);
+
+	String tmp = str;
+	auto ci = map.Find(tmp);
+
+	if (ci != map.End())
+		return ci->value;
+
+	Int res = count;
+	LETHE_ASSERT(res < MAX_CHUNKS*CHUNK_SIZE);
+
+	auto &chunk = chunks[res >> CHUNK_SHIFT];
+
+	if (!chunk)
+		chunk = new String[CHUNK_SIZE];
+
+	chunk[res & (CHUNK_SIZE-1)] = tmp;
+	map[tmp] = res;
+	Atomic::Store(count, res+1);
+
+	return res;
+}
+
+// TokenFile
+
+// empty names don't touch the table so that static locations can be built before it exists
+static Int TokenFile_Intern(const char *str)
+{
+	return !str || !*str ? 0 : TokenFileTable::Get().Add(str);
+}
+
+TokenFile::TokenFile(const char *str)
+	: index(TokenFile_Intern(str))
+{
+}
+
+TokenFile::TokenFile(const String &str)
+	: index(TokenFile_Intern(str.Ansi()))
+{
+}
+
+TokenFile &TokenFile::operator =(const char *str)
+{
+	index = TokenFile_Intern(str);
+	return *this;
+}
+
+TokenFile &TokenFile::operator =(const String &str)
+{
+	index = TokenFile_Intern(str.Ansi());
+	return *this;
+}
+
+bool TokenFile::operator ==(const String &str) const
+{
+	return Get() == str;
+}
+
 // Token
 
 Token::Token()
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "../Collect/Array.h"
+#include "../Collect/HashMap.h"
 #include "../String/String.h"
+#include "../Thread/Lock.h"
+#include "../Sys/Singleton.h"
 
 namespace lethe
 {
@@ -194,11 +197,106 @@ enum TokenTypeBase
 
 typedef TokenTypeBase TokenType;
 
+LETHE_API_BEGIN
+
+// global table of interned file names
+class LETHE_API TokenFileTable
+{
+	LETHE_SINGLETON(TokenFileTable)
+public:
+	TokenFileTable();
+	~TokenFileTable();
+
+	// returns index, 0 = empty
+	Int Add(const char *str);
+	// lock-free; index must be valid
+	inline const String &GetString(Int index) const
+	{
+		LETHE_ASSERT(index >= 0 && index < Atomic::Load(count));
+		return chunks[index >> CHUNK_SHIFT][index & (CHUNK_SIZE-1)];
+	}
+
+private:
+	static const Int CHUNK_SHIFT = 10;
+	static const Int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+	static const Int MAX_CHUNKS = 4096;
+
+	// chunks never move so that Get doesn't need to lock
+	String *chunks[MAX_CHUNKS];
+	AtomicInt count;
+	HashMap<String, Int> map;
+	mutable Mutex mutex;
+};
+
+// interned file name (index into TokenFileTable)
+struct LETHE_API TokenFile
+{
+	inline TokenFile() : index(0) {}
+	TokenFile(const char *str);
+	TokenFile(const String &str);
+
+	TokenFile &operator =(const char *str);
+	TokenFile &operator =(const String &str);
+
+	inline const String &Get() const
+	{
+		return TokenFileTable::Get().GetString(index);
+	}
+
+	inline operator const String &() const
+	{
+		return Get();
+	}
+
+	inline const char *Ansi() const
+	{
+		return Get().Ansi();
+	}
+
+	inline bool IsEmpty() const
+	{
+		return !index;
+	}
+
+	inline TokenFile &Clear()
+	{
+		index = 0;
+		return *this;
+	}
+
+	inline Int GetIndex() const
+	{
+		return index;
+	}
+
+	inline bool operator ==(const TokenFile &o) const
+	{
+		return index == o.index;
+	}
+
+	inline bool operator !=(const TokenFile &o) const
+	{
+		return index != o.index;
+	}
+
+	bool operator ==(const String &str) const;
+
+	inline bool operator !=(const String &str) const
+	{
+		return !(*this == str);
+	}
+
+private:
+	Int index;
+};
+
+LETHE_API_END
+
 struct TokenLocation
 {
 	Int column, line;
-	// file; note that string data is reference-counted so no allocation problems here
-	String file;
+	// file; interned so that locations stay small and cheap to copy
+	TokenFile file;
 };
 
 union TokenNumber
@@ -0,0 +1,96 @@
+#include "ArenaAlloc.h"
+#include "AlignedAlloc.h"
+#include "../Math/Templates.h"
+
+namespace lethe
+{
+
+// ArenaAlloc
+
+ArenaAlloc::ArenaAlloc(size_t nchunkSize)
+	: head(nullptr)
+	, ptr(nullptr)
+	, end(nullptr)
+	, chunkSize(nchunkSize)
+	, usage(0)
+{
+}
+
+ArenaAlloc::~ArenaAlloc()
+{
+	Clear();
+}
+
+void ArenaAlloc::Clear()
+{
+	while (head)
+	{
+		auto *tmp = head->next;
+		BucketAllocator.CallFree(head);
+		head = tmp;
+	}
+
+	ptr = end = nullptr;
+	usage = 0;
+}
+
+void ArenaAlloc::Reset()
+{
+	Chunk *keep = nullptr;
+
+	while (head)
+	{
+		auto *tmp = head->next;
+
+		// oversized chunks are released
+		if (!keep && head->size == chunkSize)
+			keep = head;
+		else
+			BucketAllocator.CallFree(head);
+
+		head = tmp;
+	}
+
+	ptr = end = nullptr;
+	usage = 0;
+
+	if (!keep)
+		return;
+
+	keep->next = nullptr;
+	head = keep;
+	usage = keep->size;
+
+	auto *data = reinterpret_cast<Byte *>(keep);
+	ptr = data + CHUNK_HEADER;
+	end = data + keep->size;
+}
+
+void *ArenaAlloc::AllocChunk(size_t size, size_t align)
+{
+	const size_t hdr = CHUNK_HEADER;
+	// oversized allocations get a chunk of their own
+	auto csize = Max(chunkSize, hdr + size + align);
+
+	auto *chunk = static_cast<Chunk *>(BucketAllocator.CallAlloc(csize, 16));
+	chunk->next = head;
+	chunk->size = csize;
+	head = chunk;
+	usage += csize;
+
+	auto *data = reinterpret_cast<Byte *>(chunk);
+	auto *res = AlignPtr(data + hdr, align);
+
+	// keep bumping in the larger remainder
+	auto *cend = data + csize;
+
+	if (cend - (res + size) >= end - ptr)
+	{
+		ptr = res + size;
+		end = cend;
+	}
+
+	return res;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../Sys/Types.h"
+#include "../Sys/NoCopy.h"
+#include "../Sys/Likely.h"
+#include "../Ptr/RefCounted.h"
+
+namespace lethe
+{
+
+// bump allocator; individual allocations are never freed, all chunks are released at once
+// not thread-safe
+class LETHE_API ArenaAlloc : public NoCopy, public RefCounted
+{
+public:
+	explicit ArenaAlloc(size_t nchunkSize = 65536);
+	~ArenaAlloc();
+
+	inline void *Alloc(size_t size, size_t align = 16)
+	{
+		auto *res = AlignPtr(ptr, align);
+
+		if (LETHE_UNLIKELY(!res || res + size > end))
+			return AllocChunk(size, align);
+
+		ptr = res + size;
+		return res;
+	}
+
+	// release all chunks
+	void Clear();
+	// free all allocations but keep one regular chunk for reuse
+	void Reset();
+
+	// total memory allocated in chunks
+	size_t GetUsage() const {return usage;}
+
+private:
+	struct Chunk
+	{
+		Chunk *next;
+		size_t size;
+	};
+
+	Chunk *head;
+	Byte *ptr;
+	Byte *end;
+	size_t chunkSize;
+	size_t usage;
+
+	static inline Byte *AlignPtr(Byte *p, size_t align)
+	{
+		return reinterpret_cast<Byte *>(((UIntPtr)p + (align-1)) & ~(UIntPtr)(align-1));
+	}
+
+	static const size_t CHUNK_HEADER = (sizeof(Chunk) + 15) & ~(size_t)15;
+
+	void *AllocChunk(size_t size, size_t align);
+};
+
+}
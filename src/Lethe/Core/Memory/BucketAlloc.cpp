@@ -201,7 +201,7 @@ BucketAlloc::BucketObject *BucketAlloc::PtrToObject(void *ptr)
 
 void *BucketAlloc::ThreadAlloc(BucketAlloc *allocators)
 {
-	Int idx = 0;/*Thread::GetCurrentWorkerId() & (THREAD_BUCKET_CACHE_COUNT-1);*/
+	Int idx = Int(Thread::GetCurrentIndex() & (THREAD_BUCKET_CACHE_COUNT-1));
 	return allocators[idx].Alloc();
 }
 
@@ -30,8 +30,9 @@ public:
 	};
 
 	// allocates n buckets to be cached and used among threads
+	// threads pick one by index so that they rarely fight over the same lock
 	// MUST be a power of 2
-	static const Int THREAD_BUCKET_CACHE_COUNT = 1;
+	static const Int THREAD_BUCKET_CACHE_COUNT = 8;
 
 	BucketAlloc(const char *nobjName, IntPtr nelemSize, IntPtr nbucketSize = 16, Int nalign = 8, Int nflags = 0);
 	~BucketAlloc();
@@ -75,6 +75,48 @@ static bool WriteProtectSegment(void *ptr, size_t size, bool enable)
 	return res;
 }
 
+static bool ProtectDataSegment(void *ptr, size_t size, bool enable)
+{
+	LETHE_ASSERT(ptr && size);
+
+	DWORD tmp;
+	return VirtualProtect(ptr, size, enable ? PAGE_READONLY : PAGE_READWRITE, &tmp) != FALSE;
+}
+
+// reserve address space only
+static void *ReserveSegment(size_t &size)
+{
+	LETHE_ASSERT(size);
+	size_t pmask = GetPageSize()-1;
+	size += pmask;
+	size &= ~pmask;
+
+	return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+static bool CommitSegment(void *ptr, size_t size)
+{
+	LETHE_ASSERT(ptr && size);
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+static void ReleaseSegment(void *ptr, size_t)
+{
+	BOOL res = VirtualFree(ptr, 0, MEM_RELEASE);
+	LETHE_ASSERT(res);
+	(void)res;
+}
+
+static bool DiscardSegment(void *ptr, size_t size)
+{
+	LETHE_ASSERT(ptr && size);
+
+	// contents are no longer of interest; unlocking an unlocked range trims it from working set
+	bool res = VirtualAlloc(ptr, size, MEM_RESET, PAGE_READWRITE) != nullptr;
+	VirtualUnlock(ptr, size);
+	return res;
+}
+
 #else
 
 // OSX fix
@@ -127,6 +169,55 @@ static bool WriteProtectSegment(void *ptr, size_t size, bool enable)
 	return res;
 }
 
+static bool ProtectDataSegment(void *ptr, size_t size, bool enable)
+{
+	LETHE_ASSERT(ptr && size);
+
+	return !mprotect(ptr, size, enable ? PROT_READ : PROT_READ|PROT_WRITE);
+}
+
+// reserve address space only
+static void *ReserveSegment(size_t &size)
+{
+	LETHE_ASSERT(size);
+	size_t pmask = GetPageSize()-1;
+	size += pmask;
+	size &= ~pmask;
+
+	void *res = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+
+	if (res == MAP_FAILED)
+		res = nullptr;
+
+	return res;
+}
+
+static bool CommitSegment(void *ptr, size_t size)
+{
+	LETHE_ASSERT(ptr && size);
+	// physical pages are still allocated on first touch
+	return !mprotect(ptr, size, PROT_READ|PROT_WRITE);
+}
+
+static void ReleaseSegment(void *ptr, size_t size)
+{
+	FreeSegment(ptr, size);
+}
+
+static bool DiscardSegment(void *ptr, size_t size)
+{
+	LETHE_ASSERT(ptr && size);
+
+#if LETHE_OS_LINUX || LETHE_OS_ANDROID
+	// releases pages immediately, they read back as zero
+	return !madvise(ptr, size, MADV_DONTNEED);
+#elif defined(MADV_FREE)
+	return !madvise(ptr, size, MADV_FREE);
+#else
+	return !madvise(ptr, size, MADV_DONTNEED);
+#endif
+}
+
 #endif
 
 // Heap
@@ -151,6 +242,49 @@ void Heap::FreeExecutableMemory(void *ptr, size_t size)
 	FreeSegment(ptr, size);
 }
 
+void *Heap::AllocatePages(size_t &size)
+{
+	return AllocSegment(size);
+}
+
+void Heap::FreePages(void *ptr, size_t size)
+{
+	FreeSegment(ptr, size);
+}
+
+bool Heap::WriteProtectPages(void *ptr, size_t size, bool enable)
+{
+	return ProtectDataSegment(ptr, size, enable);
+}
+
+void *Heap::ReservePages(size_t &size)
+{
+	return ReserveSegment(size);
+}
+
+bool Heap::CommitPages(void *ptr, size_t size)
+{
+	return CommitSegment(ptr, size);
+}
+
+void Heap::ReleasePages(void *ptr, size_t size)
+{
+	ReleaseSegment(ptr, size);
+}
+
+size_t Heap::DiscardPages(void *ptr, size_t size)
+{
+	const size_t pmask = GetOSPageSize()-1;
+
+	auto start = ((UIntPtr)ptr + pmask) & ~(UIntPtr)pmask;
+	auto end = ((UIntPtr)ptr + size) & ~(UIntPtr)pmask;
+
+	if (end <= start || !DiscardSegment(reinterpret_cast<void *>(start), end - start))
+		return 0;
+
+	return end - start;
+}
+
 #if LETHE_OS_WINDOWS && LETHE_64BIT
 
 // reference: https://bugzilla.mozilla.org/show_bug.cgi?id=844196
@@ -22,6 +22,25 @@ public:
 	// enable/disable write protection for executable memory region
 	// returns true on success
 	static bool WriteProtectExecutableMemory(void *ptr, size_t size, bool enable);
+	// page-aligned data, size is rounded up to nearest page
+	// returns null on error
+	static void *AllocatePages(size_t &size);
+	// size = rounded size from previous call to AllocatePages
+	static void FreePages(void *ptr, size_t size);
+	// make data pages read-only or writable again
+	// returns true on success
+	static bool WriteProtectPages(void *ptr, size_t size, bool enable);
+	// reserve address space without committing memory, size is rounded up to nearest page
+	// returns null on error
+	static void *ReservePages(size_t &size);
+	// commit part of reserved range (page-aligned) as read-write
+	static bool CommitPages(void *ptr, size_t size);
+	// size = rounded size from previous call to ReservePages
+	static void ReleasePages(void *ptr, size_t size);
+	// release physical memory of whole pages inside range, keeping address space mapped
+	// range may be part of any heap block; contents become undefined
+	// returns number of bytes discarded
+	static size_t DiscardPages(void *ptr, size_t size);
 	// necessary for 64-bit JIT on windows
 	static bool RegisterExecutableMemory(void *ptr, size_t size);
 	static bool UnregisterExecutableMemory(void *ptr);
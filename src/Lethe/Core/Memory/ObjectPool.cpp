@@ -0,0 +1,212 @@
+#include "ObjectPool.h"
+#include "AlignedAlloc.h"
+#include "../Sys/Assert.h"
+#include "../Sys/Likely.h"
+#include "../Math/Templates.h"
+#include "../Collect/Array.h"
+
+namespace lethe
+{
+
+// ObjectPool
+
+ObjectPool::ObjectPool(size_t nblockSize, size_t ngroupKey)
+	: partialHead(nullptr)
+	, partialTail(nullptr)
+	, emptySlab(nullptr)
+	, blockSize(0)
+	, groupKey(ngroupKey)
+	, live(0)
+	, peak(0)
+	, allocs(0)
+	, slabs(0)
+{
+	const size_t hdr = sizeof(UIntPtr);
+	// freelist is linked through block memory
+	nblockSize = Max(nblockSize, sizeof(void *));
+	stride = (nblockSize + hdr + MAX_ALIGN-1) & ~(MAX_ALIGN-1);
+	blockSize = stride - hdr;
+	// first block must be aligned
+	dataOfs = ((sizeof(Slab) + hdr + MAX_ALIGN-1) & ~(MAX_ALIGN-1)) - hdr;
+	slabSize = Max(SLAB_SIZE, dataOfs + stride*16);
+	slotsPerSlab = Int((slabSize - dataOfs) / stride);
+}
+
+ObjectPool::~ObjectPool()
+{
+	LETHE_ASSERT(!live && "object pool contains live blocks!");
+
+	while (partialHead)
+	{
+		auto *tmp = partialHead->next;
+		ObjectAllocator.CallFree(partialHead);
+		partialHead = tmp;
+	}
+}
+
+void *ObjectPool::Alloc()
+{
+	SpinMutexLock _(mutex);
+	return AllocInternal();
+}
+
+Int ObjectPool::AllocBatch(void **blocks, Int count)
+{
+	SpinMutexLock _(mutex);
+
+	for (Int i=0; i<count; i++)
+	{
+		blocks[i] = AllocInternal();
+
+		if (!blocks[i])
+			return i;
+	}
+
+	return count;
+}
+
+void *ObjectPool::AllocInternal()
+{
+	Slab *s = partialTail;
+
+	if (LETHE_UNLIKELY(!s))
+	{
+		s = static_cast<Slab *>(ObjectAllocator.CallAlloc(slabSize, MAX_ALIGN));
+
+		if (!s)
+			return nullptr;
+
+		s->pool = this;
+		s->prev = s->next = nullptr;
+		s->freeList = nullptr;
+		s->bump = 0;
+		s->live = 0;
+		LETHE_DLIST_ADD(s, partialHead, partialTail, prev, next);
+		++slabs;
+	}
+
+	if (s == emptySlab)
+		emptySlab = nullptr;
+
+	void *res = s->freeList;
+
+	if (res)
+		s->freeList = *static_cast<void **>(res);
+	else
+	{
+		// sequential slots first, header is written once
+		auto *slot = reinterpret_cast<Byte *>(s) + dataOfs + (size_t)s->bump++ * stride;
+		*reinterpret_cast<Slab **>(slot) = s;
+		res = slot + sizeof(UIntPtr);
+	}
+
+	if (++s->live == slotsPerSlab)
+		LETHE_DLIST_UNLINK(s, partialHead, partialTail, prev, next);
+
+	++allocs;
+	peak = Max(peak, ++live);
+
+	return res;
+}
+
+void ObjectPool::Free(void *ptr)
+{
+	if (!ptr)
+		return;
+
+	LETHE_ASSERT(IsPooled(ptr));
+	auto *slab = reinterpret_cast<Slab *>(GetHeader(ptr));
+	auto *pool = slab->pool;
+
+	SpinMutexLock _(pool->mutex);
+	pool->FreeInternal(slab, ptr);
+}
+
+void ObjectPool::FreeBatch(void * const *blocks, Int count)
+{
+	SpinMutexLock _(mutex);
+
+	for (Int i=0; i<count; i++)
+	{
+		auto *slab = reinterpret_cast<Slab *>(GetHeader(blocks[i]));
+		LETHE_ASSERT(slab->pool == this);
+		FreeInternal(slab, blocks[i]);
+	}
+}
+
+void ObjectPool::FreeInternal(Slab *s, void *ptr)
+{
+	LETHE_ASSERT(s->live > 0 && live > 0);
+	--live;
+
+	*static_cast<void **>(ptr) = s->freeList;
+	s->freeList = ptr;
+
+	// move to tail so that the next alloc reuses this (hot) block
+	if (s != partialTail)
+	{
+		if (s->live != slotsPerSlab)
+			LETHE_DLIST_UNLINK(s, partialHead, partialTail, prev, next);
+
+		LETHE_DLIST_ADD(s, partialHead, partialTail, prev, next);
+	}
+
+	if (--s->live)
+		return;
+
+	// keep one empty slab around to avoid thrashing
+	if (emptySlab)
+	{
+		LETHE_DLIST_UNLINK(emptySlab, partialHead, partialTail, prev, next);
+		ObjectAllocator.CallFree(emptySlab);
+		--slabs;
+	}
+
+	emptySlab = s;
+	s->freeList = nullptr;
+	s->bump = 0;
+}
+
+size_t ObjectPool::GetBlockSize(const void *ptr)
+{
+	LETHE_ASSERT(IsPooled(ptr));
+	return reinterpret_cast<const Slab *>(GetHeader(ptr))->pool->blockSize;
+}
+
+void *ObjectPool::AllocLarge(size_t size, size_t align)
+{
+	size_t ofs = Max(align, MAX_ALIGN);
+	auto *blk = static_cast<Byte *>(ObjectAllocator.CallAlloc(size + ofs, ofs));
+
+	if (!blk)
+		return nullptr;
+
+	auto *res = blk + ofs;
+	reinterpret_cast<UIntPtr *>(res)[-1] = ((UIntPtr)ofs << 1) | 1;
+	reinterpret_cast<UIntPtr *>(res)[-2] = (UIntPtr)size;
+	return res;
+}
+
+void ObjectPool::FreeLarge(void *ptr)
+{
+	if (!ptr)
+		return;
+
+	LETHE_ASSERT(!IsPooled(ptr));
+	ObjectAllocator.CallFree(static_cast<Byte *>(ptr) - (GetHeader(ptr) >> 1));
+}
+
+void ObjectPool::GetStats(Stats &stats) const
+{
+	SpinMutexLock _(mutex);
+
+	stats.blockSize = blockSize;
+	stats.groupKey = groupKey;
+	stats.live = live;
+	stats.peak = peak;
+	stats.allocs = allocs;
+	stats.slabs = slabs;
+	stats.memUsage = slabs * slabSize;
+}
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "../Sys/Types.h"
+#include "../Sys/NoCopy.h"
+#include "../Thread/Lock.h"
+
+namespace lethe
+{
+
+// slab allocator for fixed-size blocks, used by ObjectHeap
+// each block is preceded by a header word pointing to its slab, blocks are 16-byte aligned
+// freed blocks are reused LIFO from the most recently touched slab to keep them warm in cache
+class LETHE_API ObjectPool : public NoCopy
+{
+public:
+	// maximum alignment of pooled blocks
+	static constexpr size_t MAX_ALIGN = 16;
+	// default slab size in bytes
+	static constexpr size_t SLAB_SIZE = 16384;
+
+	struct Stats
+	{
+		// usable block size
+		size_t blockSize;
+		// group key (class name hash) or 0 if shared
+		size_t groupKey;
+		// number of live blocks, including blocks held by thread caches
+		size_t live;
+		// peak number of live blocks
+		size_t peak;
+		// total number of allocations so far
+		ULong allocs;
+		// number of slabs
+		size_t slabs;
+		// memory used by slabs
+		size_t memUsage;
+	};
+
+	explicit ObjectPool(size_t nblockSize, size_t ngroupKey = 0);
+	~ObjectPool();
+
+	void *Alloc();
+	// ptr must come from an ObjectPool
+	static void Free(void *ptr);
+
+	// batched versions for thread caches, one lock per batch
+	// returns number of blocks allocated
+	Int AllocBatch(void **blocks, Int count);
+	// all blocks must belong to this pool
+	void FreeBatch(void * const *blocks, Int count);
+
+	// pool owning pooled block
+	static inline ObjectPool *GetPool(const void *ptr)
+	{
+		return reinterpret_cast<const Slab *>(GetHeader(ptr))->pool;
+	}
+
+	// returns true if ptr was allocated by a pool (as opposed to AllocLarge)
+	static inline bool IsPooled(const void *ptr)
+	{
+		return !(GetHeader(ptr) & 1);
+	}
+
+	// usable size of pooled block
+	static size_t GetBlockSize(const void *ptr);
+
+	// blocks that don't fit any pool; use the same header layout so that pooled and large blocks
+	// can be told apart, block size is stored in front of header
+	static void *AllocLarge(size_t size, size_t align);
+	static void FreeLarge(void *ptr);
+	// requested size of large block
+	static inline size_t GetLargeSize(const void *ptr)
+	{
+		return static_cast<const UIntPtr *>(ptr)[-2];
+	}
+
+	// mark block not owned by ObjectHeap (e.g. arena memory), two header words in front of ptr must be writable
+	// it looks like an empty large block, so GetBlockSize and Trim leave it alone; it must never be freed
+	static inline void MarkForeign(void *ptr)
+	{
+		static_cast<UIntPtr *>(ptr)[-1] = 1;
+		static_cast<UIntPtr *>(ptr)[-2] = 0;
+	}
+
+	// block marked with MarkForeign
+	static inline bool IsForeign(const void *ptr)
+	{
+		return !IsPooled(ptr) && !GetLargeSize(ptr);
+	}
+
+	inline size_t GetBlockSize() const {return blockSize;}
+
+	void GetStats(Stats &stats) const;
+
+private:
+	struct Slab
+	{
+		ObjectPool *pool;
+		// partial slab chain
+		Slab *prev, *next;
+		// freelist chain, linked through block memory
+		void *freeList;
+		// bump index for never used slots
+		Int bump;
+		// live blocks in this slab
+		Int live;
+	};
+
+	static inline UIntPtr GetHeader(const void *ptr)
+	{
+		return static_cast<const UIntPtr *>(ptr)[-1];
+	}
+
+	// mutex must be held
+	void *AllocInternal();
+	void FreeInternal(Slab *slab, void *ptr);
+
+	mutable SpinMutex mutex;
+
+	// slabs with free slots, tail is the most recently touched one
+	Slab *partialHead, *partialTail;
+	// cached empty slab
+	Slab *emptySlab;
+
+	size_t blockSize;
+	size_t groupKey;
+	// slot size including header
+	size_t stride;
+	// offset of first slot from slab start
+	size_t dataOfs;
+	size_t slabSize;
+	Int slotsPerSlab;
+
+	size_t live;
+	size_t peak;
+	ULong allocs;
+	size_t slabs;
+};
+
+}
@@ -58,7 +58,7 @@ public:
 
 	inline UInt AddRef() const
 	{
-		UInt res = Atomic::Increment(strongRefCount);
+		UInt res = RefAtomic::Increment(strongRefCount);
 		LETHE_ASSERT(res);
 		return res;
 	}
@@ -67,7 +67,7 @@ public:
 	// use at your own risk!
 	inline UInt DecRefCount() const
 	{
-		return Atomic::Decrement(strongRefCount);
+		return RefAtomic::Decrement(strongRefCount);
 	}
 
 	inline UInt Release() const
@@ -84,7 +84,7 @@ public:
 	static inline UInt AddWeakRef(const RefCounted *self)
 	{
 		LETHE_ASSERT(self->strongRefCount != 0);
-		UInt res = Atomic::Increment(self->weakRefCount);
+		UInt res = RefAtomic::Increment(self->weakRefCount);
 		LETHE_ASSERT(res);
 		return res;
 	}
@@ -95,10 +95,10 @@ public:
 #endif
 	static inline UInt ReleaseWeak(const RefCounted *self)
 	{
-		UInt res = Atomic::Decrement(self->weakRefCount);
+		UInt res = RefAtomic::Decrement(self->weakRefCount);
 		LETHE_ASSERT(res != (NonAtomicType)(((UInt)0-1) & Limits<NonAtomicType>::Max()));
 
-		if (LETHE_UNLIKELY(!res && Atomic::CompareAndSwap(self->strongRefCount, (NonAtomicType)0, (NonAtomicType)0)))
+		if (LETHE_UNLIKELY(!res && RefAtomic::CompareAndSwap(self->strongRefCount, (NonAtomicType)0, (NonAtomicType)0)))
 			CustomDeleteObjectSkeleton(self);
 
 		return res;
@@ -110,7 +110,13 @@ public:
 #endif
 	static inline bool HasStrongRef(const RefCounted *self)
 	{
-		return Atomic::Load(self->strongRefCount) != 0;
+		return RefAtomic::Load(self->strongRefCount) != 0;
+	}
+
+	// only reliable if caller holds the only strong reference
+	static inline UInt GetStrongRefCount(const RefCounted *self)
+	{
+		return RefAtomic::Load(self->strongRefCount);
 	}
 
 protected:
@@ -1,11 +1,11 @@
 inline void StringData::AddRef()
 {
-	Atomic::Increment(refCount);
+	RefAtomic::Increment(refCount);
 }
 
 inline void StringData::Release()
 {
-	if (!Atomic::Decrement(refCount))
+	if (!RefAtomic::Decrement(refCount))
 	{
 		// for safety, we clear string data (just in case it'd hold password text etc.)
 		MemSet(this, 0, sizeof(StringData) + capacity*sizeof(char));
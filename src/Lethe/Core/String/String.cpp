@@ -926,7 +926,7 @@ char String::operator[](int index) const
 
 bool String::IsUnique() const
 {
-	return !data || Atomic::Load(data->refCount) == 1;
+	return !data || RefAtomic::Load(data->refCount) == 1;
 }
 
 String &String::CloneData()
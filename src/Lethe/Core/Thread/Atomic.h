@@ -71,6 +71,20 @@ struct LETHE_API Atomic
 	static void Pause();
 };
 
+// reference counter atomics
+// building with LETHE_SINGLE_THREADED_REFS turns these into plain arithmetic; refcounted objects
+// (including script objects and strings) must not be shared between threads then
+struct LETHE_API RefAtomic
+{
+	template< typename T > static inline T Load(const volatile T &t);
+	// returns new value
+	template< typename T > static inline T Increment(volatile T &t);
+	// returns new value
+	template< typename T > static inline T Decrement(volatile T &t);
+	// returns true if t == cmp
+	template< typename T > static inline bool CompareAndSwap(volatile T &t, T cmp, T xch);
+};
+
 #include "Inline/Atomic.inl"
 
 }
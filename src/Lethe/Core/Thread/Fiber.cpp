@@ -0,0 +1,260 @@
+#include "../Sys/Platform.h"
+#include "../Memory/Heap.h"
+#include "Fiber.h"
+
+#if LETHE_OS_WINDOWS
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	include <windows.h>
+#	undef min
+#	undef max
+#else
+#	if (LETHE_OS_OSX || LETHE_OS_IOS) && !defined(_XOPEN_SOURCE)
+#		define _XOPEN_SOURCE 600
+#	endif
+#	include <ucontext.h>
+#endif
+
+namespace lethe
+{
+
+static thread_local Fiber *currentFiber = nullptr;
+
+// Fiber
+
+#if LETHE_OS_WINDOWS
+
+struct Fiber::Context
+{
+	void *handle = nullptr;
+	void *caller = nullptr;
+	// reserved range, lowest page is a guard page, user memory is on top
+	void *userBase = nullptr;
+	size_t userSize = 0;
+	void *user = nullptr;
+};
+
+static void WINAPI FiberProc(void *param)
+{
+	static_cast<Fiber *>(param)->PrivateRun();
+}
+
+Fiber::Fiber(const Delegate<void()> &nentry, size_t stackSize, size_t userSize)
+	: entry(nentry)
+	, context(new Context)
+	, done(false)
+	, running(false)
+{
+	if (userSize)
+	{
+		// guard page below user memory (scripts keep their stack there)
+		const size_t guard = Heap::GetOSPageSize();
+		context->userSize = guard + userSize;
+		auto *user = static_cast<Byte *>(Heap::ReservePages(context->userSize));
+
+		if (!user)
+			return;
+
+		if (!Heap::CommitPages(user + guard, context->userSize - guard))
+		{
+			Heap::ReleasePages(user, context->userSize);
+			return;
+		}
+
+		context->userBase = user;
+		context->user = user + guard;
+	}
+
+	context->handle = CreateFiberEx(0, stackSize, FIBER_FLAG_FLOAT_SWITCH, FiberProc, this);
+}
+
+Fiber::~Fiber()
+{
+	LETHE_ASSERT(!running);
+
+	if (context->handle)
+		DeleteFiber(context->handle);
+
+	if (context->userBase)
+		Heap::ReleasePages(context->userBase, context->userSize);
+
+	delete context;
+}
+
+bool Fiber::IsValid() const
+{
+	return context->handle != nullptr;
+}
+
+bool Fiber::Resume()
+{
+	if (!IsValid() || done || running)
+		return false;
+
+	// thread must be a fiber to switch to another one
+	if (!IsThreadAFiber() && !ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH))
+		return false;
+
+	context->caller = GetCurrentFiber();
+
+	auto *prev = currentFiber;
+	currentFiber = this;
+	running = true;
+
+	SwitchToFiber(context->handle);
+
+	running = false;
+	currentFiber = prev;
+
+	return !done;
+}
+
+void Fiber::SwitchBack()
+{
+	SwitchToFiber(context->caller);
+}
+
+#else
+
+struct Fiber::Context
+{
+	ucontext_t fiber;
+	ucontext_t caller;
+	// reserved range: guard page, stack, guard page, user memory
+	void *stack = nullptr;
+	size_t stackSize = 0;
+	void *user = nullptr;
+};
+
+// makecontext only passes ints
+static void FiberProc(int lo, int hi)
+{
+	ULong adr = (ULong)(UInt)lo | ((ULong)(UInt)hi << 32);
+	reinterpret_cast<Fiber *>((UIntPtr)adr)->PrivateRun();
+}
+
+// kept out of Fiber ctor so that its locals aren't live across getcontext (-Wclobbered)
+static bool Fiber_GetContext(ucontext_t &uc)
+{
+	return getcontext(&uc) == 0;
+}
+
+Fiber::Fiber(const Delegate<void()> &nentry, size_t stackSize, size_t userSize)
+	: entry(nentry)
+	, context(new Context)
+	, done(false)
+	, running(false)
+{
+	const size_t guard = Heap::GetOSPageSize();
+	stackSize = (stackSize + guard-1) & ~(guard-1);
+
+	// single mapping for guard, stack and user memory
+	// user memory gets its own guard page: scripts keep their stack there, growing down towards native stack
+	const size_t userGuard = userSize ? guard : 0;
+	context->stackSize = guard + stackSize + userGuard + userSize;
+	auto *stk = static_cast<Byte *>(Heap::ReservePages(context->stackSize));
+
+	if (!stk)
+		return;
+
+	auto *user = stk + guard + stackSize + userGuard;
+
+	if (!Heap::CommitPages(stk + guard, stackSize) || (userSize && !Heap::CommitPages(user, userSize)) ||
+		!Fiber_GetContext(context->fiber))
+	{
+		Heap::ReleasePages(stk, context->stackSize);
+		return;
+	}
+
+	context->stack = stk;
+	context->user = userSize ? user : nullptr;
+	context->fiber.uc_stack.ss_sp = stk + guard;
+	context->fiber.uc_stack.ss_size = stackSize;
+	context->fiber.uc_link = nullptr;
+
+	ULong adr = (ULong)(UIntPtr)this;
+	makecontext(&context->fiber, (void (*)())FiberProc, 2, (int)(UInt)adr, (int)(UInt)(adr >> 32));
+}
+
+Fiber::~Fiber()
+{
+	LETHE_ASSERT(!running);
+
+	if (context->stack)
+		Heap::ReleasePages(context->stack, context->stackSize);
+
+	delete context;
+}
+
+bool Fiber::IsValid() const
+{
+	return context->stack != nullptr;
+}
+
+bool Fiber::Resume()
+{
+	if (!IsValid() || done || running)
+		return false;
+
+	auto *prev = currentFiber;
+	currentFiber = this;
+	running = true;
+
+	swapcontext(&context->caller, &context->fiber);
+
+	running = false;
+	currentFiber = prev;
+
+	return !done;
+}
+
+void Fiber::SwitchBack()
+{
+	swapcontext(&context->fiber, &context->caller);
+}
+
+#endif
+
+bool Fiber::Suspend()
+{
+	auto *fiber = currentFiber;
+
+	if (!fiber)
+		return false;
+
+	fiber->SwitchBack();
+	return true;
+}
+
+Fiber *Fiber::GetCurrent()
+{
+	return currentFiber;
+}
+
+void *Fiber::GetUserMemory() const
+{
+	return context->user;
+}
+
+bool Fiber::Reset()
+{
+	if (!done || running)
+		return false;
+
+	done = false;
+	return true;
+}
+
+void Fiber::PrivateRun()
+{
+	// never returns, finished fiber may be reset and resumed again
+	for (;;)
+	{
+		entry();
+		done = true;
+		SwitchBack();
+	}
+}
+
+}
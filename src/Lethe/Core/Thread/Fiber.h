@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../Sys/Assert.h"
+#include "../Sys/NoCopy.h"
+#include "../Sys/Types.h"
+#include "../Delegate/Delegate.h"
+
+namespace lethe
+{
+
+// platform-independent Fiber (cooperative thread with its own native stack)
+
+LETHE_API_BEGIN
+
+// entry runs on first Resume(); fiber can be resumed again after Reset() once entry returned
+// (stack and OS resources are reused)
+// fibers must be resumed from the thread that created them
+class LETHE_API Fiber : NoCopy
+{
+public:
+	// stackSize = reserved native stack size in bytes; pages are committed lazily where the OS allows it
+	// userSize = extra memory for user data, allocated along with the stack (placed above it where possible),
+	// separated from it by a guard page
+	explicit Fiber(const Delegate<void()> &nentry, size_t stackSize = 64*1024, size_t userSize = 0);
+	// must not be running; destroying a suspended fiber simply abandons its stack
+	~Fiber();
+
+	// true if fiber was created successfully
+	bool IsValid() const;
+
+	// switch to fiber, returns when fiber suspends or entry returns
+	// returns false if done or already running
+	bool Resume();
+
+	// suspend current fiber, switching back to whoever resumed it
+	// returns false if not called from within a fiber
+	static bool Suspend();
+
+	// current fiber or null if not inside one
+	static Fiber *GetCurrent();
+
+	// user memory (read-write, zero-filled initially), null if userSize was 0
+	void *GetUserMemory() const;
+
+	// entry returned
+	inline bool IsDone() const {return done;}
+	inline bool IsRunning() const {return running;}
+
+	// prepare fiber to run entry again; only possible when done
+	bool Reset();
+
+	// PRIVATE!!! don't touch!
+	void PrivateRun();
+
+private:
+	struct Context;
+
+	Delegate<void()> entry;
+	Context *context;
+	bool done;
+	bool running;
+
+	void SwitchBack();
+};
+
+LETHE_API_END
+
+}
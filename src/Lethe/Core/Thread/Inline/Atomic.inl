@@ -612,3 +612,53 @@ inline void Atomic::Pause()
 	asm volatile("yield");
 #endif
 }
+
+// RefAtomic
+
+template<typename T>
+inline T RefAtomic::Load(const volatile T &t)
+{
+#ifdef LETHE_SINGLE_THREADED_REFS
+	return t;
+#else
+	return Atomic::Load(t);
+#endif
+}
+
+template<typename T>
+inline T RefAtomic::Increment(volatile T &t)
+{
+#ifdef LETHE_SINGLE_THREADED_REFS
+	T res = T(t + 1);
+	t = res;
+	return res;
+#else
+	return Atomic::Increment(t);
+#endif
+}
+
+template<typename T>
+inline T RefAtomic::Decrement(volatile T &t)
+{
+#ifdef LETHE_SINGLE_THREADED_REFS
+	T res = T(t - 1);
+	t = res;
+	return res;
+#else
+	return Atomic::Decrement(t);
+#endif
+}
+
+template<typename T>
+inline bool RefAtomic::CompareAndSwap(volatile T &t, T cmp, T xch)
+{
+#ifdef LETHE_SINGLE_THREADED_REFS
+	if (t != cmp)
+		return false;
+
+	t = xch;
+	return true;
+#else
+	return Atomic::CompareAndSwap(t, cmp, xch);
+#endif
+}
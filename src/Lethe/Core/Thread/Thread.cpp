@@ -139,6 +139,14 @@ bool Thread::Run()
 	return 1;
 }
 
+// small sequential index of calling thread, assigned on first call
+UInt Thread::GetCurrentIndex()
+{
+	static AtomicUInt counter = 0;
+	static thread_local UInt index = Atomic::Increment(counter) - 1;
+	return index;
+}
+
 // sleep in ms
 void Thread::Sleep(int ms)
 {
@@ -66,6 +66,9 @@ public:
 	// sleep in ms
 	static void Sleep(int ms);
 
+	// small sequential index of calling thread, assigned on first use; for sharding
+	static UInt GetCurrentIndex();
+
 	// PRIVATE!!! don't touch!
 	void PrivateStartWork();
 };
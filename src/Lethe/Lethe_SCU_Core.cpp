@@ -11,9 +11,11 @@
 #include "Core/Lexer/Token.cpp"
 #include "Core/Math/Math.cpp"
 #include "Core/Memory/AlignedAlloc.cpp"
+#include "Core/Memory/ArenaAlloc.cpp"
 #include "Core/Memory/BucketAlloc.cpp"
 #include "Core/Memory/Heap.cpp"
 #include "Core/Memory/Memory.cpp"
+#include "Core/Memory/ObjectPool.cpp"
 #include "Core/Ptr/RefCounted.cpp"
 #include "Core/String/CharConv.cpp"
 #include "Core/String/Name.cpp"
@@ -29,4 +31,5 @@
 #include "Core/Sys/Platform.cpp"
 #include "Core/Thread/Lock.cpp"
 #include "Core/Thread/Thread.cpp"
+#include "Core/Thread/Fiber.cpp"
 #include "Core/Time/Timer.cpp"
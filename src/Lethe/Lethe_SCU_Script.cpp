@@ -90,6 +90,7 @@
 #include "Script/AutoCompleteEngine.cpp"
 #include "Script/Compiler/Compiler.cpp"
 #include "Script/Compiler/Compiler_Declaration.cpp"
+#include "Script/Compiler/Compiler_Escape.cpp"
 #include "Script/Compiler/Compiler_Expression.cpp"
 #include "Script/Compiler/Compiler_Statement.cpp"
 #include "Script/Compiler/Compiler_Template.cpp"
@@ -101,6 +102,9 @@
 #include "Script/Program/CompiledProgram.cpp"
 #include "Script/Program/CompiledProgram_Emit.cpp"
 #include "Script/Program/ConstPool.cpp"
+#include "Script/Program/GlobalSnapshot.cpp"
+#include "Script/Program/HeapProfiler.cpp"
+#include "Script/Program/ReadOnlyData.cpp"
 #include "Script/ScriptContext.cpp"
 #include "Script/ScriptEngine.cpp"
 #include "Script/ScriptInit.cpp"
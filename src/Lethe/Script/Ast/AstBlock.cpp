@@ -8,8 +8,6 @@ namespace lethe
 
 // AstBlock
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstBlock)
-
 bool AstBlock::ResolveNode(const ErrorHandler &)
 {
 	if (nodes.IsEmpty())
@@ -7,8 +7,6 @@ namespace lethe
 
 class LETHE_API AstBlock : public AstNode
 {
-	LETHE_BUCKET_ALLOC(AstBlock)
-
 public:
 	LETHE_AST_NODE(AstBlock)
 
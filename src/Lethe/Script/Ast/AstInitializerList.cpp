@@ -11,8 +11,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstInitializerList)
-
 // AstInitializerList
 
 bool AstInitializerList::IsCompleteInitializedElem(CompiledProgram &p, AstNode *n, QDataType elem) const
@@ -269,7 +267,25 @@ bool AstInitializerList::GenInitializerList(CompiledProgram &p, QDataType qdt, I
 			return p.Error(this, "mixed designators not allowed");
 	}
 
-	Int lastDesignatorOffset = Limits<Int>::MIN;
+	// declaration order of designated member; offsets don't follow it for reordered fields
+	auto declIndex = [&bases](const DataType::Member *m) -> Int
+	{
+		Int res = 0;
+
+		for (Int j=bases.GetSize()-1; j>=0; j--)
+		{
+			const auto &mems = bases[j]->members;
+
+			if (m >= mems.GetData() && m < mems.GetData() + mems.GetSize())
+				return res + Int(m - mems.GetData());
+
+			res += mems.GetSize();
+		}
+
+		return res;
+	};
+
+	Int lastDesignatorIndex = Limits<Int>::MIN;
 
 	for (Int i=0; i<nodes.GetSize(); i++)
 	{
@@ -286,14 +302,14 @@ bool AstInitializerList::GenInitializerList(CompiledProgram &p, QDataType qdt, I
 			if (!m)
 				return p.Error(nodes[i], String::Printf("member `%s' not found", designators[i].name.Ansi()));
 
-			ofs = (Int)m->offset;
+			auto didx = declIndex(m);
 
-			if (ofs < lastDesignatorOffset)
+			if (didx < lastDesignatorIndex)
 				p.Warning(nodes[i], String::Printf("out of order designated initialization of `%s'",
 					designators[i].name.Ansi()),
 					WARN_OUT_OF_ORDER_DESIGNATED_INITIALIZER);
 
-			lastDesignatorOffset = ofs;
+			lastDesignatorIndex = didx;
 		}
 		else
 		{
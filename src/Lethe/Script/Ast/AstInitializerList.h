@@ -9,8 +9,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstInitializerList : public AstNode
 {
-	LETHE_BUCKET_ALLOC(AstInitializerList)
-
 public:
 	LETHE_AST_NODE(AstInitializerList)
 
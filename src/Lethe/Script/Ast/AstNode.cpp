@@ -32,7 +32,56 @@ namespace lethe
 {
 
 // allocators
-LETHE_AST_BUCKET_ALLOC_DEF(AstNode)
+
+static thread_local ArenaAlloc *currentAstArena = nullptr;
+
+struct AstAllocHeader
+{
+	// node size (no node comes close to 4G)
+	UInt size;
+	// nonzero if allocated from an arena
+	UInt fromArena;
+};
+
+// nodes only need pointer alignment; an 8-byte header keeps it
+static const size_t AST_ALLOC_HEADER = 8;
+
+AstArenaScope::AstArenaScope(ArenaAlloc *narena)
+	: oldArena(currentAstArena)
+{
+	currentAstArena = narena;
+}
+
+AstArenaScope::~AstArenaScope()
+{
+	currentAstArena = oldArena;
+}
+
+void *AstNode::operator new(size_t sz)
+{
+	auto *arena = currentAstArena;
+
+	auto *res = static_cast<Byte *>(arena ? arena->Alloc(sz + AST_ALLOC_HEADER, 8) :
+		BucketAllocator.CallAlloc(sz + AST_ALLOC_HEADER, 8));
+
+	LETHE_COMPILE_ASSERT(sizeof(AstAllocHeader) <= AST_ALLOC_HEADER);
+	auto *hdr = reinterpret_cast<AstAllocHeader *>(res);
+	hdr->size = (UInt)sz;
+	hdr->fromArena = arena != nullptr;
+	return res + AST_ALLOC_HEADER;
+}
+
+void AstNode::operator delete(void *ptr)
+{
+	if (!ptr)
+		return;
+
+	auto *base = static_cast<Byte *>(ptr) - AST_ALLOC_HEADER;
+
+	// arena memory is only released with the arena
+	if (!reinterpret_cast<AstAllocHeader *>(base)->fromArena)
+		BucketAllocator.CallFree(base);
+}
 
 // must be in sync with enum!
 static const char *AST_TYPE_NAMES[] =
@@ -322,7 +371,7 @@ DataType *AstNode::GenFuncType(AstNode *fref, CompiledProgram &p, AstNode *resTy
 
 bool AstNode::BakeGlobalData(AstNode *n, QDataType qdt, Int ofs, CompiledProgram &p)
 {
-	Byte *gdata = p.cpool.data.GetData();
+	Byte *gdata = p.bakeReadOnly ? p.cpool.roData.GetData() : p.cpool.data.GetData();
 
 	switch (qdt.GetTypeEnumUnderlying())
 	{
@@ -376,6 +425,7 @@ bool AstNode::BakeGlobalData(AstNode *n, QDataType qdt, Int ofs, CompiledProgram
 
 	case DT_STRING:
 	{
+		LETHE_ASSERT(!p.bakeReadOnly);
 		auto sptr = reinterpret_cast<String *>(gdata + ofs);
 		// assume null
 		*sptr = AstStaticCast<AstText *>(n)->text;
@@ -706,6 +756,25 @@ bool AstNode::IsResolved() const
 	return (flags & AST_F_RESOLVED) != 0;
 }
 
+size_t AstNode::GetMemUsage() const
+{
+	auto *hdr = reinterpret_cast<const AstAllocHeader *>(reinterpret_cast<const Byte *>(this) - AST_ALLOC_HEADER);
+	size_t res = AST_ALLOC_HEADER + hdr->size;
+
+	// children no longer fit into the inline buffer
+	if (nodes.GetCapacity() > 2)
+		res += nodes.GetCapacity() * sizeof(AstNode *);
+
+	return res;
+}
+
+const char *AstNode::GetTypeName(AstNodeType ntype)
+{
+	// note: names are null-terminated
+	LETHE_COMPILE_ASSERT(ArraySize(AST_TYPE_NAMES) == AST_MAX+1);
+	return ntype >= 0 && ntype < AST_MAX ? AST_TYPE_NAMES[ntype] : "";
+}
+
 String AstNode::GetTextRepresentation() const
 {
 	if (type == AST_CONST_INT)
@@ -11,6 +11,7 @@
 #include <Lethe/Core/Ptr/RefCounted.h>
 #include <Lethe/Core/Io/StreamDecl.h>
 #include <Lethe/Core/Memory/BucketAlloc.h>
+#include <Lethe/Core/Memory/ArenaAlloc.h>
 #include <Lethe/Script/TypeInfo/DataTypes.h>
 
 namespace lethe
@@ -47,6 +48,8 @@ enum AstFlag : UShort
 	AST_F_ARG2_ELEM = 1 << 10,
 	AST_F_RES_ELEM = 1 << 11,
 	AST_F_RES_SLICE = 1 << 12,
+	// var decl: non-escaping new, allocate object in stack frame
+	AST_F_STACK_OBJECT = 1 << 13,
 
 	AST_F_TEMPLATE_INSTANCE = 1 << 14,
 	// type generated flag
@@ -220,7 +223,8 @@ enum AstNodeType : Short
 	AST_STATIC_ASSERT,
 	// bitfield sizeof/offsetof; both return 0 for normal fields
 	AST_BITSIZEOF,
-	AST_BITOFFSETOF
+	AST_BITOFFSETOF,
+	AST_MAX
 };
 
 template<typename T>
@@ -268,12 +272,25 @@ private:
 
 class AstSymbol;
 
-#define LETHE_AST_BUCKET_ALLOC_DEF(cls) LETHE_BUCKET_ALLOC_DEF_SIZE(cls, 256)
+// sets AST arena for current thread; nodes allocated from an arena are released with it
+// note: only node memory is batched; destructors still run per node (nodes own strings and arrays)
+// and lexer tokens don't use the arena
+struct LETHE_API AstArenaScope
+{
+	explicit AstArenaScope(ArenaAlloc *narena);
+	~AstArenaScope();
+
+private:
+	ArenaAlloc *oldArena;
+};
 
 class LETHE_API AstNode : public NoCopy
 {
-	LETHE_BUCKET_ALLOC(AstNode)
 public:
+	// all node types share this; uses current AST arena if any
+	void *operator new(size_t sz);
+	void operator delete(void *ptr);
+
 	AstNode(AstNodeType ntype, const TokenLocation &nloc);
 
 	virtual ~AstNode();
@@ -439,6 +456,11 @@ public:
 	void Dump(Stream &s, Int level = 0) const;
 	virtual String GetTextRepresentation() const;
 
+	// memory used by this node (excluding children)
+	size_t GetMemUsage() const;
+
+	static const char *GetTypeName(AstNodeType ntype);
+
 	// get symbol scope
 	const NamedScope *GetSymScope(bool parentOnly) const;
 
@@ -21,6 +21,15 @@ namespace lethe
 
 // AstSymbol
 
+// push address of global variable
+static void AstSymbol_EmitGlobalAdr(CompiledProgram &p, const AstNode *target, Int frameOfs)
+{
+	if (target->qualifiers & AST_Q_READ_ONLY)
+		p.EmitReadOnlyAdr(frameOfs);
+	else
+		p.EmitU24(OPC_GLOADADR, frameOfs);
+}
+
 bool AstSymbol::FoldConst(const CompiledProgram &p)
 {
 	auto *ctarget = DerefConstant(p);
@@ -419,7 +428,7 @@ bool AstSymbol::CodeGenRef(CompiledProgram &p, bool allowConst, bool derefPtr)
 			}
 		}
 		else
-			p.EmitI24(OPC_GLOADADR, frameOfs);
+			AstSymbol_EmitGlobalAdr(p, target, frameOfs);
 
 		p.PushStackType(refType);
 		return true;
@@ -759,7 +768,7 @@ bool AstSymbol::CodeGenInternal(CompiledProgram &p)
 				return true;
 			}
 
-			p.EmitU24(OPC_GLOADADR, frameOfs);
+			AstSymbol_EmitGlobalAdr(p, target, frameOfs);
 			p.PushStackType(refType);
 			return true;
 		}
@@ -770,7 +779,7 @@ bool AstSymbol::CodeGenInternal(CompiledProgram &p)
 			Int stkSize = (dt.GetSize() + Stack::WORD_SIZE-1)/Stack::WORD_SIZE;
 			p.EmitU24Zero(hasDtor ? OPC_PUSHZ_RAW : OPC_PUSH_RAW, stkSize);
 			// push source adr
-			p.EmitU24(OPC_GLOADADR, frameOfs);
+			AstSymbol_EmitGlobalAdr(p, target, frameOfs);
 			// push dest adr
 			p.EmitI24(OPC_LPUSHADR, 1);
 
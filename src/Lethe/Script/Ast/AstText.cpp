@@ -6,8 +6,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstText)
-
 // AstText
 
 AstNode *AstText::ResolveTemplateScope(AstNode *&ntext) const
@@ -7,8 +7,6 @@ namespace lethe
 
 class LETHE_API AstText : public AstNode
 {
-	LETHE_BUCKET_ALLOC(AstText)
-
 public:
 	LETHE_AST_NODE(AstText)
 
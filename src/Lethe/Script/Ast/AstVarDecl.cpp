@@ -6,14 +6,15 @@
 #include <Lethe/Script/Vm/Stack.h>
 #include <Lethe/Script/Vm/Opcodes.h>
 #include <Lethe/Script/Ast/Function/AstFunc.h>
+#include <Lethe/Script/Ast/Function/AstCall.h>
+#include <Lethe/Script/Ast/Types/AstFuncBase.h>
+#include <Lethe/Script/Ast/UnaryOp/AstUnaryNew.h>
 #include <Lethe/Script/Compiler/Warnings.h>
 #include "CodeGenTables.h"
 
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstVarDecl)
-
 // AstVarDecl
 
 QDataType AstVarDecl::GetTypeDesc(const CompiledProgram &p) const
@@ -152,6 +153,553 @@ void AstVarDecl::AddLiveRefs(AstNode *n)
 	}
 }
 
+// borrowed locals: strong ptr initialized from a reference that provably outlives it
+// doesn't need to add a reference (and release it when leaving scope)
+
+// releasing a value of this type may run script code
+// (expression types may carry skip_dtor, so check the underlying type)
+static bool AstVarDecl_ReleaseRunsCode(QDataType qdt)
+{
+	qdt.qualifiers &= ~AST_Q_SKIP_DTOR;
+	return qdt.HasDtor() && qdt.GetTypeEnum() != DT_STRING;
+}
+
+// use of a pointer var which can neither modify nor alias the variable
+static bool AstVarDecl_IsReadOnlyUse(const CompiledProgram &p, const AstNode *n)
+{
+	const auto *par = n->parent;
+
+	if (!par)
+		return false;
+
+	switch(par->type)
+	{
+	case AST_OP_DOT:
+	case AST_IF:
+	case AST_WHILE:
+	case AST_OP_TERNARY:
+		return par->nodes[0] == n;
+
+	case AST_EXPR:
+	case AST_OP_EQ:
+	case AST_OP_NEQ:
+	case AST_UOP_LNOT:
+	case AST_OP_LAND:
+	case AST_OP_LOR:
+		return true;
+
+	case AST_OP_ASSIGN:
+		return par->nodes[1] == n;
+
+	case AST_VAR_DECL:
+		return par->nodes[1] == n && !par->GetTypeDesc(p).IsReference();
+
+	case AST_CALL:
+	{
+		const auto *fbase = AstStaticCast<const AstCall *>(par)->GetFuncBase();
+		const auto *args = fbase ? fbase->GetArgs() : nullptr;
+
+		if (!args || par->nodes[0] == n)
+			return false;
+
+		Int idx = 0;
+
+		while (par->nodes[idx+1] != n)
+			idx++;
+
+		if (idx >= args->nodes.GetSize())
+			return fbase->HasEllipsis();
+
+		const auto *arg = args->nodes[idx];
+
+		if (arg->type == AST_ARG_ELLIPSIS)
+			return true;
+
+		auto atype = arg->GetTypeDesc(p);
+		return !atype.IsReference() || atype.IsConst();
+	}
+
+	default:
+		return false;
+	}
+}
+
+// local var or arg holding a strong ptr, never modified in enclosing function
+static bool AstVarDecl_IsReadOnlyLocal(const CompiledProgram &p, const AstNode *var, const AstNode *fn)
+{
+	if (!var || (var->type != AST_VAR_DECL && var->type != AST_ARG))
+		return false;
+
+	if (var->type == AST_VAR_DECL &&
+		(!var->scopeRef || !var->scopeRef->IsLocal() || ((var->qualifiers | var->parent->nodes[0]->qualifiers) & AST_Q_STATIC)))
+	{
+		return false;
+	}
+
+	auto vtype = var->GetTypeDesc(p);
+
+	if (vtype.GetTypeEnum() != DT_STRONG_PTR || vtype.IsReference())
+		return false;
+
+	const AstNode *n;
+
+	for (AstConstIterator it(fn); (n = it.Next()) != nullptr;)
+	{
+		if (n->target != var || n->parent == var)
+			continue;
+
+		LETHE_RET_FALSE(n->type == AST_IDENT && AstVarDecl_IsReadOnlyUse(p, n));
+	}
+
+	return true;
+}
+
+// local var which holds a reference of its own and is never modified
+// args don't hold a reference (caller's source may be released meanwhile), neither do borrowed locals
+static bool AstVarDecl_IsOwningLocal(const CompiledProgram &p, const AstNode *var, const AstNode *fn)
+{
+	LETHE_RET_FALSE(var && var->type == AST_VAR_DECL && AstVarDecl_IsReadOnlyLocal(p, var, fn));
+
+	// conservative: anything that could borrow is treated as borrowed
+	const auto *vdecl = AstStaticCast<const AstVarDecl *>(var);
+	return vdecl->nodes.GetSize() < 2 || vdecl->nodes[1]->type == AST_INITIALIZER_LIST || !vdecl->CanBorrowInit(p);
+}
+
+// source location which can only change by assignment or by running script code
+static bool AstVarDecl_IsStableSource(const CompiledProgram &p, const AstNode *n)
+{
+	switch(n->type)
+	{
+	case AST_THIS:
+		return true;
+
+	case AST_IDENT:
+	{
+		const auto *targ = n->target;
+
+		return targ && (targ->type == AST_VAR_DECL || targ->type == AST_ARG) &&
+			!(targ->qualifiers & AST_Q_PROPERTY) && !targ->GetTypeDesc(p).IsReference();
+	}
+
+	case AST_OP_DOT:
+	{
+		const auto *targ = n->nodes[1]->target;
+
+		return targ && targ->type == AST_VAR_DECL && !(targ->qualifiers & AST_Q_PROPERTY) &&
+			AstVarDecl_IsStableSource(p, n->nodes[0]);
+	}
+
+	case AST_OP_SUBSCRIPT:
+	{
+		auto dte = n->nodes[0]->GetTypeDesc(p).GetTypeEnum();
+
+		return (dte == DT_STATIC_ARRAY || dte == DT_DYNAMIC_ARRAY || dte == DT_ARRAY_REF) &&
+			AstVarDecl_IsStableSource(p, n->nodes[0]);
+	}
+
+	default:
+		return false;
+	}
+}
+
+static bool AstVarDecl_IsCallFree(const CompiledProgram &p, const AstNode *root)
+{
+	const AstNode *n;
+
+	for (AstConstIterator it(root); (n = it.Next()) != nullptr;)
+	{
+		if (n->type >= AST_CONST_BOOL && n->type <= AST_CONST_STRING)
+			continue;
+
+		if (n->type >= AST_TYPE_VOID && n->type <= AST_TYPE_AUTO)
+			continue;
+
+		if (n->type >= AST_UOP_PLUS && n->type <= AST_OP_LOR && n->type != AST_OP_THROW)
+		{
+			// struct operators are calls
+			for (const auto *it : n->nodes)
+				LETHE_RET_FALSE(it->GetTypeDesc(p).GetTypeEnum() != DT_STRUCT);
+
+			continue;
+		}
+
+		switch(n->type)
+		{
+		case AST_EXPR:
+		case AST_BLOCK:
+		case AST_IF:
+		case AST_WHILE:
+		case AST_RETURN:
+		case AST_RETURN_VALUE:
+		case AST_BREAK:
+		case AST_CONTINUE:
+		case AST_EMPTY:
+		case AST_VAR_DECL_LIST:
+		case AST_OP_TERNARY:
+			break;
+
+		case AST_IDENT:
+			LETHE_RET_FALSE(!n->target || !(n->target->qualifiers & AST_Q_PROPERTY));
+			break;
+
+		case AST_OP_DOT:
+		{
+			const auto *targ = n->nodes[1]->target;
+			LETHE_RET_FALSE(!targ || (!(targ->qualifiers & AST_Q_PROPERTY) && targ->type != AST_NPROP_METHOD));
+			break;
+		}
+
+		case AST_OP_SUBSCRIPT:
+			LETHE_RET_FALSE(n->nodes[0]->GetTypeDesc(p).GetTypeEnum() != DT_STRUCT);
+			break;
+
+		case AST_VAR_DECL:
+			LETHE_RET_FALSE(!AstVarDecl_ReleaseRunsCode(n->GetTypeDesc(p)));
+			break;
+
+		case AST_OP_ASSIGN:
+		case AST_OP_ADD_ASSIGN:
+		case AST_OP_SUB_ASSIGN:
+		case AST_OP_MUL_ASSIGN:
+		case AST_OP_DIV_ASSIGN:
+		case AST_OP_MOD_ASSIGN:
+		case AST_OP_SHL_ASSIGN:
+		case AST_OP_SHR_ASSIGN:
+		case AST_OP_AND_ASSIGN:
+		case AST_OP_XOR_ASSIGN:
+		case AST_OP_OR_ASSIGN:
+		{
+			auto ltype = n->nodes[0]->GetTypeDesc(p);
+			LETHE_RET_FALSE(ltype.GetTypeEnum() != DT_STRUCT);
+
+			// returning a pointer stores into zeroed result
+			bool isReturn = n->parent && n->parent->type == AST_EXPR && n->parent->parent &&
+				n->parent->parent->type == AST_RETURN && ltype.IsPointer();
+
+			LETHE_RET_FALSE(isReturn || !AstVarDecl_ReleaseRunsCode(ltype));
+			break;
+		}
+
+		default:
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool AstVarDecl::CanBorrowInit(const CompiledProgram &p) const
+{
+	const auto *init = nodes[1];
+
+	LETHE_RET_FALSE(init->GetTypeDesc(p).GetTypeEnum() == DT_STRONG_PTR);
+
+	const AstNode *fn = parent;
+
+	while (fn && fn->type != AST_FUNC)
+		fn = fn->parent;
+
+	LETHE_RET_FALSE(fn);
+
+	// copy of an owning local that is never modified: calls are fine, the local keeps the object alive
+	if (init->type == AST_IDENT && AstVarDecl_IsOwningLocal(p, init->target, fn) && AstVarDecl_IsReadOnlyLocal(p, this, fn))
+		return true;
+
+	// otherwise the source must not change until leaving scope: no calls and no releases
+	LETHE_RET_FALSE(AstVarDecl_IsStableSource(p, init));
+
+	const auto *list = parent;
+	const auto *block = list->parent;
+
+	LETHE_RET_FALSE(list->type == AST_VAR_DECL_LIST && block && (block->type == AST_BLOCK || block->type == AST_FUNC_BODY));
+
+	bool after = false;
+
+	for (const auto *it : list->nodes)
+	{
+		LETHE_RET_FALSE(!after || AstVarDecl_IsCallFree(p, it));
+		after |= it == this;
+	}
+
+	after = false;
+
+	for (const auto *it : block->nodes)
+	{
+		LETHE_RET_FALSE(!after || AstVarDecl_IsCallFree(p, it));
+		after |= it == list;
+	}
+
+	return true;
+}
+
+// constant global of plain data can live in shared read-only data
+static bool AstVarDecl_CanPlaceReadOnly(const CompiledProgram &p, const AstNode *varType, const AstNode *init, QDataType qdt)
+{
+	LETHE_RET_FALSE(p.ReadOnlyDataAllowed() && (varType->qualifiers & AST_Q_CONST) && !qdt.IsReference());
+	LETHE_RET_FALSE(!qdt.HasCtor() && !qdt.HasDtor() && p.cpool.CanAllocReadOnly(qdt));
+
+	// __init modifies the variable
+	if (qdt.IsStruct() && varType->target)
+	{
+		const auto *sym = varType->target->scopeRef->FindSymbol(p.GetInternalFuncName(CompiledProgram::IFUNC_INIT), true);
+		LETHE_RET_FALSE(!sym || sym->type != AST_FUNC);
+	}
+
+	return init->IsInitializerConst(p, qdt);
+}
+
+// number of leaf initializers
+static Int AstVarDecl_CountInitializers(const AstNode *n)
+{
+	if (n->type != AST_INITIALIZER_LIST)
+		return 1;
+
+	Int res = 0;
+
+	for (const auto *it : n->nodes)
+		res += AstVarDecl_CountInitializers(it);
+
+	return res;
+}
+
+// constant initializer list of plain data can be baked into global data and copied at once;
+// sparse lists like {0} for big arrays stay per element so that we don't waste global space
+static bool AstVarDecl_CanBulkInit(const CompiledProgram &p, const AstNode *init, QDataType qdt)
+{
+	LETHE_RET_FALSE(!qdt.HasCtor() && !qdt.HasDtor());
+
+	Int size = qdt.GetSize();
+	LETHE_RET_FALSE(size > 2*Stack::WORD_SIZE);
+	LETHE_RET_FALSE(2*Stack::WORD_SIZE*AstVarDecl_CountInitializers(init) >= size);
+
+	return init->IsInitializerConst(p, qdt);
+}
+
+// definite assignment: local without initializer doesn't have to be zeroed
+// if every path assigns it as a whole before reading it
+
+enum AstVarDecl_Assign
+{
+	ASSIGN_NONE,
+	// assigned or statement doesn't complete normally
+	ASSIGN_DONE,
+	// may be read first
+	ASSIGN_FAIL
+};
+
+// any use of var; jump targets count as uses as they may skip assignment
+static bool AstVarDecl_IsUsed(const AstNode *root, const AstNode *var)
+{
+	const AstNode *n;
+
+	for (AstConstIterator it(root); (n = it.Next()) != nullptr;)
+	{
+		if (n->target == var || n->type == AST_LABEL || n->type == AST_CASE || n->type == AST_CASE_DEFAULT)
+			return true;
+	}
+
+	return false;
+}
+
+// types only zeroed for safety: numbers, plain gap-free structs and static arrays of these
+static bool AstVarDecl_IsPlainData(const QDataType &qdt)
+{
+	LETHE_RET_FALSE(!qdt.IsReference() && !qdt.HasCtor() && !qdt.HasDtor());
+
+	const auto &dt = qdt.GetType();
+
+	switch(dt.type)
+	{
+	case DT_STATIC_ARRAY:
+		return AstVarDecl_IsPlainData(dt.elemType);
+
+	case DT_STRUCT:
+		// gaps are zeroed so that structs can be compared bitwise
+		LETHE_RET_FALSE(!((qdt.qualifiers | dt.structQualifiers) & AST_Q_HAS_GAPS));
+		LETHE_RET_FALSE(dt.baseType.GetTypeEnum() == DT_NONE || AstVarDecl_IsPlainData(dt.baseType));
+
+		for (auto &&it : dt.members)
+			LETHE_RET_FALSE(it.type.IsProperty() || AstVarDecl_IsPlainData(it.type));
+
+		return true;
+
+	default:
+		return !qdt.ZeroInit();
+	}
+}
+
+// counter is only read: never modified or passed to a reference argument
+static bool AstVarDecl_IsReadOnlyCounter(const AstNode *expr, const AstNode *ctr)
+{
+	const AstNode *n;
+
+	for (AstConstIterator it(expr); (n = it.Next()) != nullptr;)
+	{
+		if ((n->type >= AST_UOP_PREINC && n->type <= AST_UOP_REF) || (n->type >= AST_OP_ASSIGN && n->type <= AST_OP_OR_ASSIGN))
+			LETHE_RET_FALSE(!AstVarDecl_IsUsed(n->nodes[0], ctr));
+
+		// swap writes both sides
+		if (n->type == AST_OP_SWAP || n->type == AST_OP_SWAP_NULL)
+			LETHE_RET_FALSE(!AstVarDecl_IsUsed(n, ctr));
+
+		if (n->type != AST_CALL)
+			continue;
+
+		// only direct calls of script functions are known to take it by value
+		const auto *fn = n->nodes[0]->type == AST_IDENT ? n->nodes[0]->target : nullptr;
+		const auto *args = fn && fn->type == AST_FUNC ? AstStaticCast<const AstFunc *>(fn)->GetArgs() : nullptr;
+
+		for (Int i=1; i<n->nodes.GetSize(); i++)
+		{
+			if (n->nodes[i]->target != ctr)
+				continue;
+
+			LETHE_RET_FALSE(args && i-1 < args->nodes.GetSize() && args->nodes[i-1]->type == AST_ARG);
+			LETHE_RET_FALSE(!(args->nodes[i-1]->nodes[0]->qualifiers & AST_Q_REFERENCE));
+		}
+	}
+
+	return true;
+}
+
+// for (int i=0; i<count; i++) var[i] = expr; fills the whole static array
+static bool AstVarDecl_IsFillLoop(const AstNode *n, const AstNode *var, Int count)
+{
+	LETHE_RET_FALSE(count > 0 && n->type == AST_FOR && n->nodes.GetSize() == 4);
+
+	const auto *init = n->nodes[0];
+	LETHE_RET_FALSE(init->type == AST_VAR_DECL_LIST && init->nodes.GetSize() == 2 && init->nodes[0]->type == AST_TYPE_INT);
+
+	const auto *ctr = init->nodes[1];
+	LETHE_RET_FALSE(ctr->nodes.GetSize() == 2 && ctr->nodes[1]->type == AST_CONST_INT && ctr->nodes[1]->num.i == 0);
+
+	const auto *cond = n->nodes[1];
+	LETHE_RET_FALSE(cond->type == AST_OP_LT && cond->nodes[0]->type == AST_IDENT && cond->nodes[0]->target == ctr);
+	LETHE_RET_FALSE(cond->nodes[1]->type == AST_CONST_INT && cond->nodes[1]->num.i == count);
+
+	const auto *step = n->nodes[2];
+	LETHE_RET_FALSE(step->type == AST_EXPR && step->nodes.GetSize() == 1);
+	step = step->nodes[0];
+	LETHE_RET_FALSE(step->type == AST_UOP_PREINC || step->type == AST_UOP_POSTINC);
+	LETHE_RET_FALSE(step->nodes[0]->type == AST_IDENT && step->nodes[0]->target == ctr);
+
+	// body must be the element assignment alone
+	const auto *body = n->nodes[3];
+
+	if (body->type == AST_BLOCK && body->nodes.GetSize() == 1)
+		body = body->nodes[0];
+
+	LETHE_RET_FALSE(body->type == AST_EXPR && body->nodes.GetSize() == 1 && body->nodes[0]->type == AST_OP_ASSIGN);
+
+	const auto *asgn = body->nodes[0];
+	const auto *lhs = asgn->nodes[0];
+
+	LETHE_RET_FALSE(lhs->type == AST_OP_SUBSCRIPT && lhs->nodes[0]->type == AST_IDENT && lhs->nodes[0]->target == var);
+	LETHE_RET_FALSE(lhs->nodes[1]->type == AST_IDENT && lhs->nodes[1]->target == ctr);
+
+	return !AstVarDecl_IsUsed(asgn->nodes[1], var) && AstVarDecl_IsReadOnlyCounter(asgn->nodes[1], ctr);
+}
+
+static AstVarDecl_Assign AstVarDecl_AssignStmt(const AstNode *n, const AstNode *var, Int count);
+
+static AstVarDecl_Assign AstVarDecl_AssignSeq(const AstNode *block, Int from, const AstNode *var, Int count)
+{
+	for (Int i=from; i<block->nodes.GetSize(); i++)
+	{
+		auto res = AstVarDecl_AssignStmt(block->nodes[i], var, count);
+
+		if (res != ASSIGN_NONE)
+			return res;
+	}
+
+	return ASSIGN_NONE;
+}
+
+// count: number of elements if var is a static array, 0 otherwise
+static AstVarDecl_Assign AstVarDecl_AssignStmt(const AstNode *n, const AstNode *var, Int count)
+{
+	switch(n->type)
+	{
+	case AST_EXPR:
+	{
+		const auto *asgn = n->nodes.GetSize() == 1 ? n->nodes[0] : nullptr;
+
+		if (asgn && asgn->type == AST_OP_ASSIGN && asgn->nodes[0]->type == AST_IDENT && asgn->nodes[0]->target == var)
+			return AstVarDecl_IsUsed(asgn->nodes[1], var) ? ASSIGN_FAIL : ASSIGN_DONE;
+
+		break;
+	}
+
+	case AST_BLOCK:
+		return AstVarDecl_AssignSeq(n, 0, var, count);
+
+	case AST_FOR:
+		if (AstVarDecl_IsFillLoop(n, var, count))
+			return ASSIGN_DONE;
+
+		break;
+
+	case AST_IF:
+	{
+		if (AstVarDecl_IsUsed(n->nodes[0], var))
+			return ASSIGN_FAIL;
+
+		auto res = AstVarDecl_AssignStmt(n->nodes[1], var, count);
+		auto resElse = n->nodes.GetSize() > 2 ? AstVarDecl_AssignStmt(n->nodes[2], var, count) : ASSIGN_NONE;
+
+		if (res == ASSIGN_FAIL || resElse == ASSIGN_FAIL)
+			return ASSIGN_FAIL;
+
+		// assigning on some paths only doesn't hurt, reads do
+		return res == ASSIGN_DONE && resElse == ASSIGN_DONE ? ASSIGN_DONE : ASSIGN_NONE;
+	}
+
+	case AST_RETURN:
+	case AST_RETURN_VALUE:
+	case AST_BREAK:
+	case AST_CONTINUE:
+		// loops and switches are never entered here, so these always leave var scope
+		return AstVarDecl_IsUsed(n, var) ? ASSIGN_FAIL : ASSIGN_DONE;
+
+	default:;
+	}
+
+	return AstVarDecl_IsUsed(n, var) ? ASSIGN_FAIL : ASSIGN_NONE;
+}
+
+bool AstVarDecl::IsAssignedBeforeUse(const QDataType &qdt) const
+{
+	LETHE_RET_FALSE(AstVarDecl_IsPlainData(qdt));
+
+	const Int count = qdt.GetTypeEnum() == DT_STATIC_ARRAY ? qdt.GetType().arrayDims : 0;
+
+	const auto *list = parent;
+	const auto *block = list ? list->parent : nullptr;
+
+	LETHE_RET_FALSE(list && list->type == AST_VAR_DECL_LIST && block && (block->type == AST_BLOCK || block->type == AST_FUNC_BODY));
+
+	Int idx = list->nodes.FindIndex(const_cast<AstVarDecl *>(this));
+	Int listIdx = block->nodes.FindIndex(const_cast<AstNode *>(list));
+
+	LETHE_RET_FALSE(idx >= 0 && listIdx >= 0);
+
+	// jump into the rest of the block could skip assignment
+	for (Int i=listIdx+1; i<block->nodes.GetSize(); i++)
+	{
+		const AstNode *n;
+
+		for (AstConstIterator it(block->nodes[i]); (n = it.Next()) != nullptr;)
+			LETHE_RET_FALSE(n->type != AST_LABEL && n->type != AST_CASE && n->type != AST_CASE_DEFAULT);
+	}
+
+	auto res = AstVarDecl_AssignSeq(list, idx+1, this, count);
+
+	if (res == ASSIGN_NONE)
+		res = AstVarDecl_AssignSeq(block, listIdx+1, this, count);
+
+	return res != ASSIGN_FAIL;
+}
+
 bool AstVarDecl::CodeGen(CompiledProgram &p)
 {
 	if (qualifiers & AST_Q_PROPERTY)
@@ -221,6 +769,9 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 		if (tdesc.GetSize() > 512 * 1024)
 			return p.Error(this, "variable too big to fit on stack (>512kb)");
 
+		bool stackObject = false;
+		bool borrowed = false;
+
 		// we have two cases now: with init or without init
 		// FIXME: refactor!
 		if (!isInitializerList && nodes.GetSize() > 1)
@@ -243,7 +794,13 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 					snode->target->qualifiers |= AST_Q_REF_ALIASED;
 			}
 
-			LETHE_RET_FALSE(tdesc.IsReference() ? nodes[1]->CodeGenRef(p, tdesc.IsConst()) : nodes[1]->CodeGen(p));
+			stackObject = (flags & AST_F_STACK_OBJECT) && nodes[1]->type == AST_NEW && !tdesc.IsReference() &&
+				tdesc.GetTypeEnum() == DT_STRONG_PTR && AstStaticCast<const AstUnaryNew *>(nodes[1])->CanAllocOnStack(p);
+
+			if (stackObject)
+				LETHE_RET_FALSE(AstStaticCast<AstUnaryNew *>(nodes[1])->CodeGenStackObject(p, *scopeRef));
+			else
+				LETHE_RET_FALSE(tdesc.IsReference() ? nodes[1]->CodeGenRef(p, tdesc.IsConst()) : nodes[1]->CodeGen(p));
 
 			if (tdesc.IsReference())
 			{
@@ -272,8 +829,12 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 
 			if (!top.IsReference() && (top.qualifiers & AST_Q_SKIP_DTOR) && top.IsPointer())
 			{
+				borrowed = p.RefCountElisionAllowed() && !stackObject && !(flags & AST_F_NRVO) &&
+					tdesc.GetTypeEnum() == DT_STRONG_PTR && CanBorrowInit(p);
+
 				// this is to fix a case when we do A a = this;
-				p.EmitAddRef(top);
+				if (!borrowed)
+					p.EmitAddRef(top);
 			}
 
 			if (!tdesc.CanAlias(top))
@@ -296,11 +857,20 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 		Int varIdx = ((flags & AST_F_NRVO) && offset >= 0) ? offset : scopeRef->AllocVar(tdesc);
 		offset = varIdx;
 
+		// object storage is destroyed separately or borrowed var doesn't own a reference
+		if ((stackObject || borrowed) && !(flags & AST_F_NRVO))
+			scopeRef->localVars.Back().type.qualifiers |= AST_Q_SKIP_DTOR;
+
+		bool bulkInit = isInitializerList && !(flags & AST_F_NRVO) && AstVarDecl_CanBulkInit(p, nodes[1], tdesc);
+
 		if (isInitializerList || nodes.GetSize() <= 1)
 		{
 			Int words = (scopeRef->varOfs - oldOfs + Stack::WORD_SIZE-1)/Stack::WORD_SIZE;
 
-			if (words)
+			// bulk copy overwrites everything
+			if (bulkInit && words*Stack::WORD_SIZE == tdesc.GetSize())
+				p.EmitI24(OPC_PUSH_RAW, words);
+			else if (words)
 			{
 				// always zero-init; we could only skip zero-init if:
 				// - no ctor/dtor needed and noinit specified
@@ -309,14 +879,43 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 				bool noinit = (tdesc.qualifiers & AST_Q_NOINIT) != 0 || isCompleteInitializerList;
 				bool zeroInit = tdesc.ZeroInit() || !noinit;
 
-				p.EmitU24Zero(zeroInit ? OPC_PUSHZ_RAW : OPC_PUSH_NOZERO, words);
+				// proven to be assigned before use, so safe even if not unsafe
+				if (!isInitializerList && !(flags & AST_F_NRVO) && IsAssignedBeforeUse(tdesc))
+					p.EmitI24(OPC_PUSH_RAW, words);
+				else
+					p.EmitU24Zero(zeroInit ? OPC_PUSHZ_RAW : OPC_PUSH_NOZERO, words);
 			}
 
 			if (!(flags & AST_F_NRVO))
 				p.EmitCtor(tdesc);
 		}
 
-		if (isInitializerList)
+		if (bulkInit)
+		{
+			bool readOnly = p.ReadOnlyDataAllowed() && p.cpool.CanAllocReadOnly(tdesc);
+			Int gofs = readOnly ? p.cpool.AllocReadOnly(tdesc) : p.cpool.AllocGlobal(tdesc);
+			p.bakeReadOnly = readOnly;
+			bool res = nodes[1]->GenInitializerList(p, tdesc, gofs, 1);
+			p.bakeReadOnly = false;
+			LETHE_RET_FALSE(res);
+
+			Int lofs = p.exprStackOfs + scopeRef->varOfs - offset;
+			UInt lofsWords = lofs / Stack::WORD_SIZE;
+
+			p.EmitU24(OPC_LPUSHADR, lofsWords);
+			Int remainder = lofs - lofsWords*Stack::WORD_SIZE;
+
+			if (remainder)
+				p.EmitI24(OPC_AADD_ICONST, remainder);
+
+			if (readOnly)
+				p.EmitReadOnlyAdr(gofs);
+			else
+				p.EmitU24(OPC_GLOADADR, gofs);
+
+			p.EmitU24(OPC_PCOPY_REV, tdesc.GetSize());
+		}
+		else if (isInitializerList)
 		{
 			auto odelta = p.initializerDelta;
 			p.initializerDelta = scopeRef->varOfs - offset;
@@ -357,6 +956,29 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 		if ((Long)p.cpool.data.GetSize() + tdesc.GetSize() > 256*1024*1024)
 			return p.Error(varType, "too many globals (256M limit reached)");
 
+		if (isInitializerList && AstVarDecl_CanPlaceReadOnly(p, varType, nodes[1], tdesc))
+		{
+			String gname;
+
+			if (nodes[0]->type == AST_IDENT)
+				gname = AstStaticCast<const AstText *>(nodes[0])->GetQText(p);
+
+			offset = p.cpool.AllocReadOnlyVar(tdesc, gname);
+			qualifiers |= AST_Q_READ_ONLY;
+
+			// all elements are constant, so this only bakes data
+			Int oldPC = p.instructions.GetSize();
+			p.bakeReadOnly = true;
+			bool res = nodes[1]->GenInitializerList(p, tdesc, offset, 1);
+			p.bakeReadOnly = false;
+
+			if (res && p.instructions.GetSize() != oldPC)
+				return p.Error(this, "read-only initializer must be constant");
+
+			scopeRef->blockThis -= isStatic;
+			return res;
+		}
+
 		if (nodes[0]->type == AST_IDENT)
 		{
 			auto *gname = AstStaticCast<const AstText *>(nodes[0]);
@@ -364,7 +986,7 @@ bool AstVarDecl::CodeGen(CompiledProgram &p)
 			offset = p.cpool.AllocGlobalVar(tdesc, gname->GetQText(p));
 		}
 		else
-			offset = p.cpool.AllocGlobal(tdesc);
+			offset = p.cpool.AllocGlobalVar(tdesc, String());
 
 		if (!isInitializerList && nodes.GetSize() > 1)
 		{
@@ -11,8 +11,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstVarDecl : public AstNode
 {
-	LETHE_BUCKET_ALLOC(AstVarDecl)
-
 public:
 	LETHE_AST_NODE(AstVarDecl)
 
@@ -30,6 +28,9 @@ public:
 
 	static bool CallInit(CompiledProgram &p, const AstNode *varType, Int globalOfs, Int localOfs = 0);
 
+	// can local strong ptr borrow its initializer without adding a reference?
+	bool CanBorrowInit(const CompiledProgram &p) const;
+
 	// used by naive local ref static analysis
 	UInt modifiedCounter = 0;
 
@@ -43,6 +44,8 @@ public:
 
 private:
 	void AddLiveRefs(AstNode *n);
+	// is uninitialized local of plain type always assigned before it's read? (definite assignment)
+	bool IsAssignedBeforeUse(const QDataType &qdt) const;
 };
 
 LETHE_API_END
@@ -2,6 +2,7 @@
 #include "../AstSymbol.h"
 #include "../NamedScope.h"
 #include "../AstVarDecl.h"
+#include "AstSubscriptOp.h"
 #include <Lethe/Script/Ast/Constants/AstConstInt.h>
 #include <Lethe/Script/Ast/Function/AstFunc.h>
 #include <Lethe/Script/Program/CompiledProgram.h>
@@ -12,8 +13,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstDotOp)
-
 // AstDotOp
 
 bool AstDotOp::FoldConst(const CompiledProgram &p)
@@ -243,6 +242,13 @@ bool AstDotOp::CodeGenInternal(CompiledProgram &p)
 		return true;
 	}
 
+	if (const auto *sm = FindSoaMember(p))
+	{
+		LETHE_RET_FALSE(AstStaticCast<AstSubscriptOp *>(left)->CodeGenSoaMember(p, *sm, true));
+		p.PopStackType(1);
+		return EmitPtrLoad(right->GetTypeDesc(p), p);
+	}
+
 	LETHE_RET_FALSE(left->CodeGenRef(p, 1, 1));
 	// ok, we have pointer on top of stack...
 
@@ -295,6 +301,24 @@ bool AstDotOp::CodeGenRef(CompiledProgram &p, bool allowConst, bool derefPtr)
 	AstNode *left  = nodes[IDX_LEFT];
 	AstNode *right = nodes[IDX_RIGHT];
 
+	if (const auto *sm = FindSoaMember(p))
+	{
+		LETHE_RET_FALSE(AstStaticCast<AstSubscriptOp *>(left)->CodeGenSoaMember(p, *sm, allowConst));
+
+		auto dt = GetTypeDesc(p);
+		dt.qualifiers |= AST_Q_REFERENCE;
+		p.PopStackType(true);
+		p.PushStackType(dt);
+
+		if (derefPtr && sm->node->GetTypeDesc(p).IsPointer())
+			p.Emit(OPC_PLOADPTR_IMM);
+
+		if (!allowConst)
+			++AstStaticCast<AstVarDecl *>(right->target)->modifiedCounter;
+
+		return true;
+	}
+
 	LETHE_RET_FALSE(left->CodeGenRef(p, allowConst, 1));
 	// ok, we have pointer on top of stack...
 
@@ -381,6 +405,23 @@ bool AstDotOp::CodeGenRef(CompiledProgram &p, bool allowConst, bool derefPtr)
 	return p.Error(this, "unexpected node after `.'");
 }
 
+const DataType::Member *AstDotOp::FindSoaMember(const CompiledProgram &p) const
+{
+	const auto *left = nodes[IDX_LEFT];
+	const auto *right = nodes[IDX_RIGHT];
+
+	if (left->type != AST_OP_SUBSCRIPT || right->type != AST_IDENT || !right->target || right->target->type != AST_VAR_DECL)
+		return nullptr;
+
+	if (!AstStaticCast<const AstSubscriptOp *>(left)->IsSoaElement(p))
+		return nullptr;
+
+	const NamedScope *nscope = right->target->scopeRef;
+	QDataType mdt = nscope && nscope->node ? nscope->node->GetTypeDesc(p) : QDataType();
+
+	return mdt.ref ? mdt.ref->FindMember(AstStaticCast<const AstSymbol *>(right)->text) : nullptr;
+}
+
 bool AstDotOp::TypeGen(CompiledProgram &p)
 {
 	LETHE_RET_FALSE(Super::TypeGen(p));
@@ -7,8 +7,6 @@ namespace lethe
 
 class LETHE_API AstDotOp : public AstNode
 {
-	LETHE_BUCKET_ALLOC(AstDotOp)
-
 public:
 	LETHE_AST_NODE(AstDotOp)
 
@@ -50,6 +48,8 @@ private:
 	Int refPropLock = 0;
 
 	bool CodeGenInternal(CompiledProgram &p);
+	// member of structure-of-arrays element (left is subscript), null if none
+	const DataType::Member *FindSoaMember(const CompiledProgram &p) const;
 };
 
 
@@ -121,6 +121,81 @@ AstNode *AstSubscriptOp::GetResolveTarget() const
 	return const_cast<AstNode *>(tn);
 }
 
+bool AstSubscriptOp::IsSoaElement(const CompiledProgram &p) const
+{
+	auto qdt = nodes[0]->GetTypeDesc(p);
+	return qdt.GetTypeEnum() == DT_DYNAMIC_ARRAY && qdt.GetType().elemType.GetType().IsSoa();
+}
+
+bool AstSubscriptOp::CodeGenSoaMember(CompiledProgram &p, const DataType::Member &m, bool allowConst)
+{
+	auto qdt = nodes[0]->GetTypeDesc(p);
+
+	const bool nobounds = (qdt.qualifiers & AST_Q_NOBOUNDS) || p.GetUnsafe();
+
+	if (!allowConst && qdt.IsConst())
+		return p.Error(this, "cannot modify a constant");
+
+	const auto *field = qdt.GetType().elemType.GetType().FindSoaField(m.offset);
+
+	if (!field)
+		return p.Error(this, "cannot access soa element member");
+
+	// header: data, size, reserve
+	const Int sizeOfs = Stack::WORD_SIZE;
+	const Int reserveOfs = Stack::WORD_SIZE + (Int)sizeof(Int);
+
+	LETHE_RET_FALSE(nodes[0]->CodeGenRef(p, allowConst));
+
+	// field block = data + capacity*soaOffset
+	p.Emit(OPC_LPUSHPTR);
+	p.EmitU24(OPC_PLOADPTR_IMM, 0);
+
+	if (nobounds)
+	{
+		p.Emit(OPC_LSWAPPTR);
+		p.EmitU24(OPC_PLOAD32_IMM, reserveOfs);
+		p.EmitU24(OPC_AADD, field->soaOffset);
+	}
+	else
+	{
+		p.EmitU24(OPC_LPUSHPTR, 1);
+		p.EmitU24(OPC_PLOAD32_IMM, reserveOfs);
+		p.EmitU24(OPC_AADD, field->soaOffset);
+		p.Emit(OPC_LSWAPPTR);
+		p.EmitU24(OPC_PLOAD32_IMM, sizeOfs);
+	}
+
+	p.PopStackType(1);
+	p.PushStackType(QDataType::MakeType(p.elemTypes[DT_FUNC_PTR]));
+
+	if (!nobounds)
+		p.PushStackType(QDataType::MakeType(p.elemTypes[DT_INT]));
+
+	LETHE_RET_FALSE(nodes[1]->CodeGen(p));
+	LETHE_RET_FALSE(p.EmitConv(nodes[1], nodes[1]->GetTypeDesc(p), QDataType::MakeConstType(p.elemTypes[DT_UINT])));
+
+	if (!nobounds)
+	{
+		auto top = p.exprStack.Back();
+		p.PopStackType();
+		p.PopStackType();
+		p.PushStackType(top);
+		p.Emit(OPC_RANGE);
+	}
+
+	p.EmitU24(OPC_AADD, field->size);
+
+	p.PopStackType(1);
+	p.PopStackType(1);
+
+	auto res = m.type;
+	res.qualifiers |= AST_Q_REFERENCE;
+	p.PushStackType(res);
+
+	return true;
+}
+
 bool AstSubscriptOp::CodeGenSubscript(CompiledProgram &p, bool store, bool allowConst, bool derefPtr)
 {
 	// FIXME: better!
@@ -223,6 +298,9 @@ bool AstSubscriptOp::CodeGenSubscript(CompiledProgram &p, bool store, bool allow
 
 	const DataType &dt = qdt.GetType();
 
+	if (dt.type == DT_DYNAMIC_ARRAY && dt.elemType.GetType().IsSoa())
+		return p.Error(this, "soa array elements can only be accessed through members");
+
 	LETHE_RET_FALSE(nodes[0]->CodeGenRef(p, allowConst));
 
 	if (dt.type != DT_STATIC_ARRAY)
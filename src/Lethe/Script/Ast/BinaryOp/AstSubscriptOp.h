@@ -28,6 +28,11 @@ public:
 		return true;
 	}
 
+	// subscript into dynamic array with structure-of-arrays storage?
+	bool IsSoaElement(const CompiledProgram &p) const;
+	// push address of member of soa element
+	bool CodeGenSoaMember(CompiledProgram &p, const DataType::Member &m, bool allowConst);
+
 private:
 	bool CodeGenSubscript(CompiledProgram &p, bool store, bool allowConst, bool derefPtr = 0);
 };
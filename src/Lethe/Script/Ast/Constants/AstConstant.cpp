@@ -291,8 +291,6 @@ bool AstConstant::IsZeroConstant(const CompiledProgram &p) const
 
 // AstConstEnumBase
 
-LETHE_BUCKET_ALLOC_DEF(AstConstEnumBase)
-
 void AstConstEnumBase::CopyTo(AstNode *n) const
 {
 	Super::CopyTo(n);
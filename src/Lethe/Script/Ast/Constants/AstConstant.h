@@ -32,7 +32,6 @@ private:
 
 class LETHE_API AstConstEnumBase : public AstConstant
 {
-	LETHE_BUCKET_ALLOC(AstConstEnumBase)
 public:
 	LETHE_AST_NODE(AstConstEnumBase)
 
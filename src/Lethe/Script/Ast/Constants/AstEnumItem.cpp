@@ -5,8 +5,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstEnumItem)
-
 // AstEnumItem
 
 bool AstEnumItem::BeginCodegen(CompiledProgram &p)
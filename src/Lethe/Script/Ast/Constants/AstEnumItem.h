@@ -7,7 +7,6 @@ namespace lethe
 
 class LETHE_API AstEnumItem : public AstText
 {
-	LETHE_BUCKET_ALLOC(AstEnumItem)
 public:
 	LETHE_AST_NODE(AstEnumItem)
 
@@ -7,8 +7,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstLabel)
-
 // AstLabel
 
 AstLabel::AstLabel(const String &ntext, const TokenLocation &nloc)
@@ -9,7 +9,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstLabel : public AstText
 {
-	LETHE_BUCKET_ALLOC(AstLabel)
 	friend class AstGoto;
 public:
 	LETHE_AST_NODE(AstLabel)
@@ -5,16 +5,44 @@
 #include <Lethe/Script/Vm/Stack.h>
 #include <Lethe/Script/Vm/Opcodes.h>
 #include <Lethe/Script/Ast/Types/AstFuncBase.h>
+#include <Lethe/Script/Ast/Function/AstCall.h>
 
 namespace lethe
 {
 
 // AstReturn
 
+AstCall *AstReturn::FindTailCall(const CompiledProgram &p) const
+{
+	if (nodes.IsEmpty() || !scopeRef || !p.TailCallsAllowed() || !p.CanTailCallScope())
+		return nullptr;
+
+	// structure: return => <expr => assign>
+	const auto *expr = nodes[0];
+
+	if (expr->type != AST_EXPR || expr->nodes.GetSize() != 1)
+		return nullptr;
+
+	const auto *asgn = expr->nodes[0];
+
+	if (asgn->type != AST_OP_ASSIGN || asgn->nodes.GetSize() != 2 || asgn->nodes[1]->type != AST_CALL)
+		return nullptr;
+
+	auto *call = AstStaticCast<AstCall *>(asgn->nodes[1]);
+	return call->CanTailCall(p) ? call : nullptr;
+}
+
 bool AstReturn::CodeGen(CompiledProgram &p)
 {
 	p.SetLocation(location);
 
+	if (auto *call = FindTailCall(p))
+	{
+		LETHE_RET_FALSE(call->CodeGenTailCall(p));
+		p.MarkReturnValue(-1);
+		return true;
+	}
+
 	if (!nodes.IsEmpty())
 	{
 		const AstNode *n = this;
@@ -5,6 +5,8 @@
 namespace lethe
 {
 
+class AstCall;
+
 class LETHE_API AstReturn : public AstNode
 {
 public:
@@ -15,6 +17,10 @@ public:
 	AstReturn(const TokenLocation &nloc) : Super(AST_RETURN, nloc) {}
 
 	bool CodeGen(CompiledProgram &p) override;
+
+private:
+	// returns call node if return value is a call that can be turned into a jump
+	AstCall *FindTailCall(const CompiledProgram &p) const;
 };
 
 
@@ -9,17 +9,31 @@ namespace lethe
 
 bool AstTernaryOp::FoldConst(const CompiledProgram &p)
 {
-	if (!nodes[0]->IsConstant() || !nodes[1]->IsConstant() || !nodes[2]->IsConstant())
-		return Super::FoldConst(p);
+	bool res = nodes[0]->FoldConst(p);
 
-	auto res = nodes[0]->ToBoolConstant(p);
+	auto cond = nodes[0]->IsConstant() ? nodes[0]->ToBoolConstant(p) : -1;
 
-	if (res < 0)
-		return false;
+	if (cond < 0)
+	{
+		res |= nodes[1]->FoldConst(p);
+		res |= nodes[2]->FoldConst(p);
+		return res;
+	}
+
+	// constant condition: only fold taken branch (untaken may recurse in constexpr funcs)
+	auto nidx = 2-cond;
+	res |= nodes[nidx]->FoldConst(p);
+
+	if (!nodes[nidx]->IsConstant())
+		return res;
 
 	LETHE_ASSERT(parent);
 
-	auto nidx = 2-res;
+	auto dte = GetTypeDesc(p).GetTypeEnum();
+
+	if (nodes[nidx]->GetTypeDesc(p).GetTypeEnum() != dte && !nodes[nidx]->ConvertConstTo(dte, p))
+		return res;
+
 	auto *n = nodes[nidx];
 	UnbindNode(nidx);
 
@@ -21,8 +21,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstCall)
-
 // AstCall
 
 NamedScope *AstCall::FindSpecialADLScope(const NamedScope *tempScope, const StringRef &nname) const
@@ -410,6 +408,115 @@ QDataType AstCall::GetTypeDesc(const CompiledProgram &p) const
 	return fdef->nodes[0]->GetTypeDesc(p);
 }
 
+bool AstCall::FoldConst(const CompiledProgram &p)
+{
+	bool res = Super::FoldConst(p);
+
+	auto *cres = EvalConstExpr(p);
+
+	if (!cres)
+		return res;
+
+	cres->parent = parent;
+	LETHE_VERIFY(parent->ReplaceChild(this, cres));
+	delete this;
+	return true;
+}
+
+AstNode *AstCall::EvalConstExpr(const CompiledProgram &p) const
+{
+	// nesting and evaluation limits to stop runaway recursion
+	static thread_local Int constExprDepth = 0;
+	static thread_local Int constExprBudget = 0;
+
+	if (forceFunc || nodes[0]->type != AST_IDENT || constExprDepth >= 64)
+		return nullptr;
+
+	auto *fn = nodes[0]->target;
+
+	if (!fn || fn->type != AST_FUNC || !(fn->qualifiers & AST_Q_CONSTEXPR) || (fn->qualifiers & AST_Q_METHOD))
+		return nullptr;
+
+	const auto *func = AstStaticCast<const AstFunc *>(fn);
+	const auto *expr = func->GetConstExprResult();
+	const auto *args = func->GetArgs();
+
+	if (!expr || args->nodes.GetSize() != nodes.GetSize()-1)
+		return nullptr;
+
+	auto rtype = GetTypeDesc(p);
+
+	if (!rtype.IsElementary() || rtype.IsReference())
+		return nullptr;
+
+	for (Int i=0; i<args->nodes.GetSize(); i++)
+	{
+		if (args->nodes[i]->type != AST_ARG || !nodes[1+i]->IsConstant())
+			return nullptr;
+
+		auto atype = args->nodes[i]->GetTypeDesc(p);
+
+		if (!atype.IsElementary() || (atype.IsReference() && !atype.IsConst()))
+			return nullptr;
+	}
+
+	if (!constExprDepth)
+		constExprBudget = 4096;
+
+	if (--constExprBudget < 0)
+		return nullptr;
+
+	// evaluate on a copy of the result expression with args replaced by constants
+	AstNode tmp(AST_NONE, location);
+	tmp.Add(expr->Clone());
+
+	Array<AstNode *> stk;
+	stk.Add(tmp.nodes[0]);
+
+	while (!stk.IsEmpty())
+	{
+		auto *n = stk.Back();
+		stk.Pop();
+
+		Int argIdx = -1;
+
+		if (n->type == AST_IDENT && n->target)
+			for (Int i=0; i<args->nodes.GetSize() && argIdx < 0; i++)
+				if (n->target == args->nodes[i])
+					argIdx = i;
+
+		if (argIdx < 0)
+		{
+			for (auto *it : n->nodes)
+				stk.Add(it);
+
+			continue;
+		}
+
+		auto *c = nodes[1+argIdx]->Clone();
+		c->parent = n->parent;
+		LETHE_VERIFY(n->parent->ReplaceChild(n, c));
+		delete n;
+
+		auto dte = args->nodes[argIdx]->GetTypeDesc(p).GetTypeEnum();
+
+		if (c->GetTypeDesc(p).GetTypeEnum() != dte && !c->ConvertConstTo(dte, p))
+			return nullptr;
+	}
+
+	++constExprDepth;
+	while (tmp.FoldConst(p));
+	--constExprDepth;
+
+	if (!tmp.nodes[0]->IsConstant())
+		return nullptr;
+
+	if (tmp.nodes[0]->GetTypeDesc(p).GetTypeEnum() != rtype.GetTypeEnum() && !tmp.nodes[0]->ConvertConstTo(rtype.GetTypeEnum(), p))
+		return nullptr;
+
+	return tmp.UnbindNode(0);
+}
+
 AstNode *AstCall::GetResolveTarget() const
 {
 	auto targ = nodes[0]->GetResolveTarget();
@@ -578,6 +685,195 @@ bool AstCall::CodeGen(CompiledProgram &p)
 	return CodeGenCommon(p, keepRef, false);
 }
 
+// dynamic array methods that understand structure-of-arrays storage
+static bool AstCall_IsSoaArrayMethod(const StringRef &fname)
+{
+	static const char * const methods[] = {
+		"__da_resize", "__da_reserve", "__da_clear", "__da_reset", "__da_pop", "__da_shrink",
+		"__da_push", "__da_erase", "__da_erase_unordered"
+	};
+
+	for (auto *it : methods)
+		if (fname == StringRef(it))
+			return true;
+
+	return false;
+}
+
+// tail calls: only plain values that fit in a stack word, so that both frames have the same layout
+// and the original caller has nothing to destroy
+static bool AstCall_IsTailCallType(const QDataType &qdt)
+{
+	auto dte = qdt.GetTypeEnum();
+
+	return !qdt.IsReference() && dte >= DT_BOOL && dte <= DT_NAME && qdt.GetSize() <= Stack::WORD_SIZE;
+}
+
+static bool AstCall_IsFloatType(const QDataType &qdt)
+{
+	auto dte = qdt.GetTypeEnumUnderlying();
+	return dte == DT_FLOAT || dte == DT_DOUBLE;
+}
+
+static bool AstCall_IsTailCallFrame(const CompiledProgram &p, const AstFuncBase *fn, Int &numArgs)
+{
+	LETHE_RET_FALSE(AstCall_IsTailCallType(fn->GetResult()->GetTypeDesc(p)));
+
+	numArgs = 0;
+
+	for (const auto *it : fn->GetArgs()->nodes)
+	{
+		LETHE_RET_FALSE(it->type == AST_ARG && AstCall_IsTailCallType(it->GetTypeDesc(p)));
+		numArgs++;
+	}
+
+	return true;
+}
+
+bool AstCall::CanTailCall(const CompiledProgram &p) const
+{
+	const auto *cur = FindEnclosingFunction();
+	const auto *fn = forceFunc ? nullptr : GetFuncBase();
+
+	if (!cur || !fn || fn->type != AST_FUNC || fn->nodes.GetSize() <= AstFunc::IDX_BODY || !namedArgs.IsEmpty())
+		return false;
+
+	// leave everything special to regular calls
+	const ULong noTail = AST_Q_NATIVE | AST_Q_INTRINSIC | AST_Q_ASSERT | AST_Q_THREAD_UNSAFE |
+		AST_Q_STATE | AST_Q_STATEBREAK | AST_Q_LATENT | AST_Q_VIRTUAL | AST_Q_OVERRIDE;
+
+	if (((fn->qualifiers | cur->qualifiers) & noTail) || (fn->flags & AST_F_SKIP_CGEN))
+		return false;
+
+	if ((fn->qualifiers & AST_Q_INLINE) && p.InlineExpansionAllowed())
+		return false;
+
+	// this register is kept, so methods can only jump to methods called on implicit this
+	const bool isMethod = (fn->qualifiers & AST_Q_METHOD) != 0;
+
+	if (isMethod != ((cur->qualifiers & AST_Q_METHOD) != 0))
+		return false;
+
+	if (isMethod)
+	{
+		LETHE_RET_FALSE(nodes[0]->type == AST_IDENT);
+		LETHE_RET_FALSE(!(cur->qualifiers & AST_Q_CONST) || (fn->qualifiers & AST_Q_CONST));
+
+		const auto *fnThis = fn->scopeRef ? fn->scopeRef->FindThis(true) : nullptr;
+		const auto *curThis = cur->scopeRef ? cur->scopeRef->FindThis(true) : nullptr;
+
+		LETHE_RET_FALSE(fnThis && curThis && fnThis->IsBaseOf(curThis));
+	}
+
+	Int fnArgs, curArgs;
+	LETHE_RET_FALSE(AstCall_IsTailCallFrame(p, fn, fnArgs));
+	LETHE_RET_FALSE(AstCall_IsTailCallFrame(p, AstStaticCast<const AstFuncBase *>(cur), curArgs));
+
+	// result slot is shared
+	LETHE_RET_FALSE(fnArgs == curArgs && nodes.GetSize()-1 == fnArgs);
+
+	// args are stored into current arg slots; JIT may keep those in registers of their declared class,
+	// so each slot must stay int/ptr or float/double
+	const auto *fnArgList = fn->GetArgs();
+	const auto *curArgList = AstStaticCast<const AstFuncBase *>(cur)->GetArgs();
+
+	for (Int i=0; i<fnArgs; i++)
+	{
+		LETHE_RET_FALSE(AstCall_IsFloatType(fnArgList->nodes[i]->GetTypeDesc(p)) ==
+			AstCall_IsFloatType(curArgList->nodes[i]->GetTypeDesc(p)));
+	}
+	
+	return fn->GetResult()->GetTypeDesc(p).GetType() == cur->nodes[0]->GetTypeDesc(p).GetType();
+}
+
+bool AstCall::CodeGenTailCall(CompiledProgram &p)
+{
+	p.SetLocation(location);
+
+	String fname;
+	auto *fdef = FindFunction(fname);
+	auto *fun = AstStaticCast<AstFunc *>(const_cast<AstFuncBase *>(GetFuncBase()));
+	const auto *cur = FindEnclosingFunction();
+
+	CheckDeprecatedCall(p, fdef, fun->attributes.Get());
+
+	const auto *args = fun->GetArgs();
+	const auto *curArgs = cur->nodes[AstFunc::IDX_ARGS];
+	Int numArgs = args->nodes.GetSize();
+
+	// passing current arg in the same position => nothing to do
+	auto isSameArg = [&](Int idx) -> bool
+	{
+		const auto *argValue = nodes[idx+1];
+		const auto *targ = argValue->target;
+
+		return argValue->type == AST_IDENT && targ == curArgs->nodes[idx] &&
+			targ->GetTypeDesc(p).GetType() == args->nodes[idx]->GetTypeDesc(p).GetType();
+	};
+
+	// evaluate all args first, they may read current args
+	for (Int i = numArgs; i > 0; i--)
+	{
+		if (isSameArg(i-1))
+			continue;
+
+		AstNode *argValue = nodes[i];
+		QDataType tdesc = args->nodes[i-1]->GetTypeDesc(p);
+
+		if (tdesc.GetTypeEnum() != argValue->GetTypeDesc(p).GetTypeEnum())
+		{
+			argValue = argValue->ConvertConstTo(tdesc.GetTypeEnum(), p);
+			LETHE_RET_FALSE(argValue);
+		}
+
+		LETHE_RET_FALSE(argValue->CodeGen(p));
+
+		if (p.exprStack.IsEmpty())
+			return p.Error(argValue, "argument expression must return a value");
+
+		auto top = p.exprStack.Back();
+
+		if (!tdesc.CanAlias(top) || tdesc.GetType() != top.GetType() || tdesc.GetTypeEnum() != top.GetTypeEnum())
+			LETHE_RET_FALSE(p.EmitConv(argValue, top, tdesc));
+
+		if (Endian::IsBig() && tdesc.IsSmallNumber())
+			p.EmitI24(OPC_ISHL_ICONST, (4-tdesc.GetSize())*8);
+	}
+
+	// now overwrite current args, first arg is on top
+	for (Int i=0; i<numArgs; i++)
+	{
+		if (isSameArg(i))
+			continue;
+
+		auto dte = args->nodes[i]->GetTypeDesc(p).GetTypeEnumUnderlying();
+
+		if (dte < DT_INT)
+			dte = DT_INT;
+
+		Int delta = (p.curScope->varSize - curArgs->nodes[i]->offset + p.exprStackOfs) / Stack::WORD_SIZE;
+		p.EmitU24(opcodeLocalStore[0][dte], delta);
+		p.PopStackType(1);
+	}
+
+	// nrvo relies on caller zeroing the result
+	if (fun->offset < 0 || (fun->flags & AST_F_NRVO))
+	{
+		Int delta = (p.curScope->varSize - cur->nodes[0]->offset) / Stack::WORD_SIZE;
+		p.EmitI24(OPC_PUSHZ_RAW, 1);
+		p.EmitU24(OPC_LSTOREPTR, delta+1);
+	}
+
+	LETHE_RET_FALSE(p.TailCallScope());
+
+	if (fun->offset >= 0)
+		p.EmitBackwardJump(OPC_BR, fun->offset);
+	else
+		fun->AddForwardRef(p.EmitForwardJump(OPC_BR));
+
+	return true;
+}
+
 bool AstCall::CodeGenIntrinsic(CompiledProgram &p, AstNode *fdef)
 {
 	AstFuncBase *fn = AstStaticCast<AstFuncBase *>(fdef);
@@ -1617,6 +1913,10 @@ bool AstCall::CodeGenCommon(CompiledProgram &p, bool keepRef, bool derefPtr)
 			{
 				LETHE_ASSERT(structType.IsArray());
 				const auto &etype = structType.GetType().elemType.GetType();
+
+				if (etype.IsSoa() && structType.GetTypeEnum() == DT_DYNAMIC_ARRAY && !AstCall_IsSoaArrayMethod(fname))
+					return p.Error(this, String::Printf("`%s' not supported for soa arrays", fname.Ansi()));
+
 				p.EmitIntConst(wantTypeIndex ? etype.typeIndex : etype.size);
 			}
 
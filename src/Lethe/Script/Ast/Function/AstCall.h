@@ -11,8 +11,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstCall : public AstNode
 {
-	LETHE_BUCKET_ALLOC(AstCall)
-
 public:
 	LETHE_AST_NODE(AstCall)
 
@@ -21,6 +19,7 @@ public:
 	explicit AstCall(const TokenLocation &nloc) : Super(AST_CALL, nloc), forceFunc(nullptr) {}
 
 	ResolveResult Resolve(const ErrorHandler &e) override;
+	bool FoldConst(const CompiledProgram &p) override;
 	const AstNode *GetTypeNode() const override;
 
 	const AstNode *GetContextTypeNode(const AstNode *node) const override;
@@ -44,6 +43,11 @@ public:
 	// get function base node or null on error
 	const AstFuncBase *GetFuncBase() const;
 
+	// can be generated as a jump from a return statement of enclosing function?
+	bool CanTailCall(const CompiledProgram &p) const;
+	// store args over enclosing function args, leave scopes and jump to function
+	bool CodeGenTailCall(CompiledProgram &p);
+
 	AstNode *forceFunc;
 
 	// named arguments, can be empty
@@ -67,6 +71,10 @@ protected:
 
 	const AstNode *FindEnclosingFunction() const;
 
+	// evaluate constexpr function call with constant args, returns constant node or null
+	// only single-return functions with elementary args/result; no loops, arrays or strings
+	AstNode *EvalConstExpr(const CompiledProgram &p) const;
+
 	// find function definition
 	AstNode *FindFunction(String &fname) const;
 	// find special ADL scope for elementary type
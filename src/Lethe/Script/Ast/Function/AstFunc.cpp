@@ -15,8 +15,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstFunc)
-
 // AstFunc
 
 QDataType AstFunc::GetTypeDesc(const CompiledProgram &) const
@@ -544,6 +542,23 @@ bool AstFunc::AnalyzeFlow(CompiledProgram &p, Int startPC) const
 	return true;
 }
 
+const AstNode *AstFunc::GetConstExprResult() const
+{
+	LETHE_RET_FALSE(IDX_BODY < nodes.GetSize());
+
+	// body => return => expr => result assignment
+	const auto *body = nodes[IDX_BODY];
+	LETHE_RET_FALSE(body->nodes.GetSize() == 1 && body->nodes[0]->type == AST_RETURN);
+
+	const auto *ret = body->nodes[0];
+	LETHE_RET_FALSE(ret->nodes.GetSize() == 1 && ret->nodes[0]->type == AST_EXPR);
+
+	const auto *asgn = ret->nodes[0]->nodes.GetSize() == 1 ? ret->nodes[0]->nodes[0] : nullptr;
+	LETHE_RET_FALSE(asgn && asgn->type == AST_OP_ASSIGN && asgn->nodes.GetSize() == 2);
+
+	return asgn->nodes[1];
+}
+
 bool AstFunc::CodeGen(CompiledProgram &p)
 {
 	if ((flags & AST_F_SKIP_CGEN) && !(qualifiers & (AST_Q_FUNC_REFERENCED | AST_Q_CTOR | AST_Q_DTOR)))
@@ -561,6 +576,9 @@ bool AstFunc::CodeGen(CompiledProgram &p)
 			return p.Error(nodes[IDX_RET], "state functions cannot return values");
 	}
 
+	if ((qualifiers & AST_Q_CONSTEXPR) && ((qualifiers & (AST_Q_METHOD | AST_Q_NATIVE)) || !GetConstExprResult()))
+		return p.Error(nodes[IDX_NAME], "constexpr function must be a non-member function with a single return statement");
+
 	// [0] = ret type, [1] = name, [2] = arglist, [3] = (optional) body for non-native
 	// emit function...
 	auto *ftext = AstStaticCast<const AstText *>(nodes[IDX_NAME]);
@@ -568,6 +586,17 @@ bool AstFunc::CodeGen(CompiledProgram &p)
 
 	Int startPC = -1;
 
+	// identical code folding only applies to template instance functions
+	const auto *templ = FindTemplate();
+	const bool foldBody = p.foldIdenticalFuncs && !p.GetInline() && nodes.GetSize() > IDX_BODY &&
+		!(qualifiers & (AST_Q_CTOR | AST_Q_DTOR | AST_Q_STATE | AST_Q_STATEBREAK | AST_Q_LATENT)) &&
+		templ && (templ->qualifiers & AST_Q_TEMPLATE_INSTANTIATED);
+
+	Array<Int> foldCallers;
+	Int foldFuncCount = 0;
+	DataType *methodType = nullptr;
+	const DataType *cmpType = nullptr;
+
 	// TODO: we'll need to know more (later)
 	if (!p.GetInline())
 	{
@@ -595,6 +624,9 @@ bool AstFunc::CodeGen(CompiledProgram &p)
 			const auto fnamePlain = AstStaticCast<AstText *>(nodes[IDX_NAME])->text;
 			Int midx = vtblIndex >= 0 ? -vtblIndex : p.instructions.GetSize();
 			dt->methods[fnamePlain] = midx;
+
+			if (vtblIndex < 0)
+				methodType = dt;
 		}
 
 		// try to handle special __cmp function
@@ -631,10 +663,12 @@ bool AstFunc::CodeGen(CompiledProgram &p)
 			}
 
 			stype.ref->funCmp = startPC;
+			cmpType = stype.ref;
 		}
 
 		// fixup forward refs
-		LETHE_RET_FALSE(p.FixupHandles(forwardRefs));
+		LETHE_RET_FALSE(p.FixupHandles(forwardRefs, foldBody ? &foldCallers : nullptr));
+		foldFuncCount = p.functions.GetSize();
 	}
 
 	// enter new scope (args)
@@ -924,6 +958,21 @@ skipNrvo:;
 	{
 		p.EndStackFrame();
 
+		// skip if nested functions were generated inside body
+		if (res && foldBody && p.functions.GetSize() == foldFuncCount)
+		{
+			Int canon = p.FoldIdenticalFunc(startPC, foldCallers);
+
+			if (canon >= 0)
+			{
+				if (methodType)
+					methodType->methods[AstStaticCast<const AstText *>(nodes[IDX_NAME])->text] = canon;
+
+				if (cmpType)
+					cmpType->funCmp = canon;
+			}
+		}
+
 		// handle static global exit functions
 		if (fname.StartsWith("__exit."))
 		{
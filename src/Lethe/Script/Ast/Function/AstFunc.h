@@ -11,8 +11,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstFunc : public AstFuncBase
 {
-	LETHE_BUCKET_ALLOC(AstFunc)
-
 public:
 	LETHE_AST_NODE(AstFunc)
 
@@ -48,6 +46,9 @@ public:
 	bool ValidateSignature(const AstFunc &o, const CompiledProgram &p) const;
 	bool ValidateADLCall(const AstCall &o, const ErrorHandler &e) const;
 
+	// constexpr: result expression if body is a single return statement, null otherwise
+	const AstNode *GetConstExprResult() const;
+
 	SharedPtr<Attributes> attributes;
 
 	// for methods only
@@ -4,8 +4,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstCustomType)
-
 // AstCustomType
 
 const AstNode *AstCustomType::GetTypeNode() const
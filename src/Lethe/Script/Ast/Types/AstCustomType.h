@@ -7,8 +7,6 @@ namespace lethe
 
 class LETHE_API AstCustomType : public AstBaseType
 {
-	LETHE_BUCKET_ALLOC(AstCustomType)
-
 public:
 	LETHE_AST_NODE(AstCustomType)
 
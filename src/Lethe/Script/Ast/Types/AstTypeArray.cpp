@@ -97,6 +97,10 @@ bool AstTypeArray::TypeGen(CompiledProgram &p)
 	if (!isStatic && dt->elemType.GetTypeEnum() == DT_STATIC_ARRAY)
 		return p.Error(this, "dynamic arrays of static arrays not allowed");
 
+	// soa storage has no contiguous elements to copy
+	if (!isStatic && dt->elemType.GetType().IsSoa())
+		typeRef.qualifiers |= AST_Q_NOCOPY;
+
 	// now compute size and alignment
 	if (isStatic)
 	{
@@ -7,8 +7,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstTypeAuto)
-
 // AstTypeAuto
 
 AstNode::ResolveResult AstTypeAuto::Resolve(const ErrorHandler &e)
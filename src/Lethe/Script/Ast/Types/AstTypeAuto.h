@@ -7,7 +7,6 @@ namespace lethe
 
 class LETHE_API AstTypeAuto : public AstBaseType
 {
-	LETHE_BUCKET_ALLOC(AstTypeAuto)
 public:
 	LETHE_AST_NODE(AstTypeAuto)
 
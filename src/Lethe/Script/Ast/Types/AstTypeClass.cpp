@@ -8,8 +8,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstTypeClass)
-
 // AstTypeClass
 
 // vtblIndex starts at 1; 0 is reserved for dtor
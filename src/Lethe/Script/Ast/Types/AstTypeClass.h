@@ -9,8 +9,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstTypeClass : public AstTypeStruct
 {
-	LETHE_BUCKET_ALLOC(AstTypeClass)
-
 public:
 	LETHE_AST_NODE(AstTypeClass)
 
@@ -3,8 +3,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstTypeDynamicArray)
-
 // AstTypeDynamicArray
 
 AstTypeDynamicArray::~AstTypeDynamicArray()
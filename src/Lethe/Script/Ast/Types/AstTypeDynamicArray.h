@@ -10,7 +10,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstTypeDynamicArray : public AstTypeArray
 {
-	LETHE_BUCKET_ALLOC(AstTypeDynamicArray)
 public:
 	LETHE_AST_NODE(AstTypeDynamicArray)
 
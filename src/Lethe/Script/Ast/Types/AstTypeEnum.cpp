@@ -6,8 +6,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstTypeEnum)
-
 // AstTypeEnum
 
 bool AstTypeEnum::BeginCodegen(CompiledProgram &p)
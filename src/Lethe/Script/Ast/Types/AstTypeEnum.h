@@ -10,8 +10,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstTypeEnum : public AstCustomType
 {
-	LETHE_BUCKET_ALLOC(AstTypeEnum)
-
 public:
 	LETHE_AST_NODE(AstTypeEnum)
 
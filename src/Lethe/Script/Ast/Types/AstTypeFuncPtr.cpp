@@ -4,8 +4,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstTypeFuncPtr)
-
 // AstTypeFuncPtr
 
 const AstNode *AstTypeFuncPtr::GetTypeNode() const
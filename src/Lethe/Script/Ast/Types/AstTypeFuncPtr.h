@@ -7,8 +7,6 @@ namespace lethe
 
 class LETHE_API AstTypeFuncPtr : public AstFuncBase
 {
-	LETHE_BUCKET_ALLOC(AstTypeFuncPtr)
-
 public:
 	LETHE_AST_NODE(AstTypeFuncPtr)
 
@@ -10,7 +10,78 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstTypeStruct)
+// pending offset assignment for reordered members
+struct AstTypeStruct_FieldSlot
+{
+	Int index;
+	AstNode *node;
+	Int align;
+	Int size;
+	// 0 = hot, 1 = default, 2 = cold
+	Int rank;
+
+	// hot first, cold last, then by descending alignment; keep declaration order otherwise
+	bool operator <(const AstTypeStruct_FieldSlot &o) const
+	{
+		if (rank != o.rank)
+			return rank < o.rank;
+
+		if (align != o.align)
+			return align > o.align;
+
+		return index < o.index;
+	}
+};
+
+// structure-of-arrays layout for dynamic arrays of [soa] structs
+static bool AstTypeStruct_GenSoaLayout(CompiledProgram &p, const AstNode *n, DataType &dt, ULong qualifiers)
+{
+	if (qualifiers & AST_Q_NATIVE)
+		return p.Error(n, "native structs cannot use soa layout");
+
+	if (qualifiers & (AST_Q_CTOR | AST_Q_DTOR))
+		return p.Error(n, "soa structs cannot have constructors or destructors");
+
+	dt.soaFields.Clear();
+
+	for (const auto *dtype = &dt; dtype && dtype->type == DT_STRUCT; dtype = &dtype->baseType.GetType())
+	{
+		for (auto &&it : dtype->members)
+		{
+			if (it.bitSize)
+				return p.Error(n, "soa structs cannot have bitfields");
+
+			if (it.type.IsProperty() || !it.type.GetSize())
+				continue;
+
+			DataType::SoaField field;
+			field.offset = (Int)it.offset;
+			field.size = it.type.GetSize();
+			// temporarily holds alignment
+			field.soaOffset = it.type.GetAlign();
+			dt.soaFields.Add(field);
+		}
+	}
+
+	// descending alignment keeps each field block aligned for any capacity
+	dt.soaFields.Sort([](const DataType::SoaField &a, const DataType::SoaField &b)->bool
+	{
+		if (a.soaOffset != b.soaOffset)
+			return a.soaOffset > b.soaOffset;
+
+		return a.offset < b.offset;
+	});
+
+	Int ofs = 0;
+
+	for (auto &&it : dt.soaFields)
+	{
+		it.soaOffset = ofs;
+		ofs += it.size;
+	}
+
+	return true;
+}
 
 // AstTypeStruct
 
@@ -421,6 +492,21 @@ bool AstTypeStruct::TypeGen(CompiledProgram &p)
 			qualifiers |= AST_Q_DTOR;
 	}
 
+	// reorder fields to minimize padding? (opt-in, only for types not bound natively)
+	// the global switch also skips types used in native signatures; bitfields keep declaration order
+	bool reorder = !ncls && !Attributes::Has(attributes, "no_reorder") &&
+		((p.FieldReorderingEnabled() && p.nativeLayoutTypes.FindIndex(this) < 0) || Attributes::Has(attributes, "reorder"));
+
+	for (Int i=2; reorder && i<nodes.GetSize(); i++)
+	{
+		const auto *n = nodes[i];
+
+		if (n->type == AST_VAR_DECL_LIST && (n->nodes[0]->qualifiers & (AST_Q_BITFIELD | AST_Q_NATIVE)))
+			reorder = false;
+	}
+
+	StackArray<AstTypeStruct_FieldSlot, 32> reorderSlots;
+
 	Int nativeMembers = 0;
 	Int scriptMembers = 0;
 
@@ -591,6 +677,20 @@ bool AstTypeStruct::TypeGen(CompiledProgram &p)
 				// native members destroyed by native dtor
 				mtype.qualifiers |= AST_Q_SKIP_DTOR;
 			}
+			else if (msize && reorder)
+			{
+				// offset assigned after all members are known
+				auto *vlist = AstStaticCast<AstVarDeclList *>(n);
+
+				AstTypeStruct_FieldSlot slot;
+				slot.index = dt->members.GetSize()-1;
+				slot.node = vn;
+				slot.align = malign;
+				slot.size = msize;
+				slot.rank = Attributes::Has(vlist->attributes, "hot") ? 0 :
+					Attributes::Has(vlist->attributes, "cold") ? 2 : 1;
+				reorderSlots.Add(slot);
+			}
 			else if (msize)
 			{
 				// align offset
@@ -613,6 +713,23 @@ bool AstTypeStruct::TypeGen(CompiledProgram &p)
 		}
 	}
 
+	if (!reorderSlots.IsEmpty())
+	{
+		reorderSlots.Sort();
+
+		for (auto &&it : reorderSlots)
+		{
+			ofs += it.align-1;
+			ofs = (ofs / it.align) * it.align;
+
+			dt->members[it.index].offset = ofs;
+			it.node->offset = ofs;
+
+			ofs += it.size;
+			dt->size = Max(ofs, dt->size);
+		}
+	}
+
 	typeRef.qualifiers = qualifiers;
 
 	dt->align = Max<Int>(dt->align, minAlign);
@@ -678,9 +795,17 @@ bool AstTypeStruct::TypeGen(CompiledProgram &p)
 		p.nullStructTypeHash.Add(Name(dt->name));
 	}
 
+	const bool soa = Attributes::Has(attributes, "soa");
+
+	if (soa && dt->type != DT_STRUCT)
+		return p.Error(this, "soa layout is only supported for structs");
+
 	if (dt->type != DT_STRUCT)
 		return true;
 
+	if (soa)
+		LETHE_RET_FALSE(AstTypeStruct_GenSoaLayout(p, this, *dt, typeRef.qualifiers));
+
 	// compute AST_Q_HAS_GAPS
 
 	const auto *dtype = dt;
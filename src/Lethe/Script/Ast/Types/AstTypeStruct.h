@@ -12,8 +12,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstTypeStruct : public AstCustomType
 {
-	LETHE_BUCKET_ALLOC(AstTypeStruct)
-
 public:
 	LETHE_AST_NODE(AstTypeStruct)
 
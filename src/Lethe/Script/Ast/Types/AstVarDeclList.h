@@ -10,8 +10,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstVarDeclList : public AstCustomType
 {
-	LETHE_BUCKET_ALLOC(AstVarDeclList)
-
 public:
 	LETHE_AST_NODE(AstVarDeclList)
 
@@ -1,9 +1,12 @@
 #include "AstUnaryNew.h"
 #include <Lethe/Script/Program/CompiledProgram.h>
+#include <Lethe/Script/Program/HeapProfiler.h>
 #include <Lethe/Script/Vm/Opcodes.h>
 #include <Lethe/Script/Ast/CodeGenTables.h>
 #include <Lethe/Script/Ast/Types/AstTypeClass.h>
 #include <Lethe/Script/Ast/Types/AstTypeDef.h>
+#include <Lethe/Script/Ast/Function/AstFunc.h>
+#include <Lethe/Script/Ast/AstText.h>
 
 namespace lethe
 {
@@ -107,6 +110,71 @@ bool AstUnaryNew::CodeGen(CompiledProgram &p)
 		p.EmitI24(OPC_BCALL, BUILTIN_ADD_STRONG_AFTER_NEW);
 	}
 
+	if (p.HeapProfilingEnabled())
+	{
+		// site index is resolved at codegen time so that it survives code relocation
+		String fname = "(global)";
+
+		if (const auto *fn = FindEnclosingFunction())
+			fname = AstStaticCast<const AstText *>(fn->nodes[AstFunc::IDX_NAME])->GetQText(p);
+
+		p.EmitIntConst(p.cpool.heapProfiler->AddSite(fname, location.file, location.line));
+		p.EmitI24(OPC_BCALL, BUILTIN_HEAP_PROF_NEW);
+	}
+
+	p.PushStackType(ldt);
+	return true;
+}
+
+const AstNode *AstUnaryNew::FindEnclosingFunction() const
+{
+	const AstNode *res = parent;
+
+	while (res && res->type != AST_FUNC)
+		res = res->parent;
+
+	return res;
+}
+
+const AstNode *AstUnaryNew::GetClassNode() const
+{
+	const auto *targ = nodes[IDX_CLASS]->target;
+
+	while (targ && targ->type == AST_TYPEDEF)
+		targ = targ->GetTypeNode();
+
+	return targ && targ->type == AST_CLASS ? targ : nullptr;
+}
+
+bool AstUnaryNew::CanAllocOnStack(const CompiledProgram &p) const
+{
+	LETHE_RET_FALSE(p.StackObjectsAllowed() && GetClassNode());
+
+	const auto &dt = GetTypeDesc(p).GetType().elemType.GetType();
+
+	// note: stack is only word-aligned
+	return dt.type == DT_CLASS && dt.funCtor >= 0 && dt.funDtor >= 0 &&
+		dt.align <= Stack::WORD_SIZE && dt.size <= MAX_STACK_OBJECT_SIZE;
+}
+
+bool AstUnaryNew::CodeGenStackObject(CompiledProgram &p, NamedScope &nscope)
+{
+	auto ldt = GetTypeDesc(p);
+	const auto &dt = ldt.GetType().elemType.GetType();
+
+	// storage is a local var of class type so that leaving scope calls class dtor directly
+	Int oldOfs = nscope.varOfs;
+	nscope.AllocVar(QDataType::MakeType(dt));
+	Int words = (nscope.varOfs - oldOfs + Stack::WORD_SIZE-1)/Stack::WORD_SIZE;
+
+	p.EmitU24Zero(OPC_PUSHZ_RAW, words);
+	p.Emit(OPC_LPUSHADR);
+	p.EmitNameConst(AstStaticCast<const AstTypeClass *>(GetClassNode())->GetName());
+	p.EmitI24(OPC_BCALL, BUILTIN_NEW_INPLACE);
+
+	p.EmitBackwardJump(OPC_CALL, dt.funCtor);
+	p.EmitI24(OPC_POP, 1);
+
 	p.PushStackType(ldt);
 	return true;
 }
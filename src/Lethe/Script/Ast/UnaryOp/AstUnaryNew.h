@@ -15,6 +15,12 @@ public:
 		IDX_CLASS
 	};
 
+	enum
+	{
+		// larger objects always go to heap
+		MAX_STACK_OBJECT_SIZE = 4096
+	};
+
 	typedef AstUnaryOp Super;
 
 	explicit AstUnaryNew(const TokenLocation &nloc) : Super(AST_NEW, nloc) {}
@@ -29,6 +35,18 @@ public:
 
 	bool CodeGen(CompiledProgram &p) override;
 	QDataType GetTypeDesc(const CompiledProgram &p) const override;
+
+	// can construct in stack frame instead of heap? (static class with small size/alignment)
+	bool CanAllocOnStack(const CompiledProgram &p) const;
+	// allocate storage in nscope and construct object there; pushes strong ptr
+	bool CodeGenStackObject(CompiledProgram &p, NamedScope &nscope);
+
+	// static class target (typedefs resolved) or null for dynamic new
+	const AstNode *GetClassNode() const;
+
+private:
+	// function containing this new expression or null for global initializers
+	const AstNode *FindEnclosingFunction() const;
 };
 
 }
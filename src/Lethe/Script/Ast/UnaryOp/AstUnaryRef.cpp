@@ -6,8 +6,6 @@
 namespace lethe
 {
 
-LETHE_AST_BUCKET_ALLOC_DEF(AstUnaryRef)
-
 // AstUnaryRef
 
 AstUnaryRef::~AstUnaryRef()
@@ -10,7 +10,6 @@ LETHE_API_BEGIN
 
 class LETHE_API AstUnaryRef : public AstUnaryOp
 {
-	LETHE_BUCKET_ALLOC(AstUnaryRef)
 public:
 	LETHE_AST_NODE(AstUnaryRef)
 
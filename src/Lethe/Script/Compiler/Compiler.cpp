@@ -49,6 +49,7 @@ Compiler::Compiler(Threaded, AtomicInt *pstaticInitCtr)
 	, pstaticInitCounter(pstaticInitCtr)
 	, floatLitIsDouble(false)
 {
+	astArena = new ArenaAlloc;
 	globalScope = new NamedScope(NSCOPE_GLOBAL);
 }
 
@@ -62,6 +63,9 @@ Compiler::Compiler()
 	, pstaticInitCounter(&staticInitCounter)
 	, floatLitIsDouble(false)
 {
+	astArena = new ArenaAlloc;
+	AstArenaScope arenaScope(astArena);
+
 	globalScope = new NamedScope(NSCOPE_GLOBAL);
 	InitNativeTypeScopes();
 
@@ -518,8 +522,6 @@ bool Compiler::ParseMacro(Int depth, bool conditionalOnly)
 
 		LETHE_RET_FALSE(ExpectPrev(ts->GetToken().type == TOK_RBR, "expected `)'"));
 
-		auto eloc = expr->location;
-
 		AstNode tmpn(AST_NONE, TokenLocation());
 		tmpn.Add(expr);
 
@@ -925,6 +927,8 @@ AstNode *Compiler::CompileBuffered(Stream &s, const String &nfilename, Double *i
 
 AstNode *Compiler::CompileInternal(bool nbuffered, Stream &s, const String &nfilename, Double *ioTime)
 {
+	AstArenaScope arenaScope(astArena);
+
 	LETHE_RET_FALSE(nbuffered ? OpenBuffered(s, nfilename, ioTime) : Open(s, nfilename));
 
 	Path p = nfilename;
@@ -1045,6 +1049,14 @@ bool Compiler::Merge(Compiler &c)
 	auto *plist = c.progList.Get();
 	LETHE_RET_FALSE(plist);
 
+	AstArenaScope arenaScope(astArena);
+
+	// merged nodes live in c's arena
+	mergedArenas.Add(c.astArena);
+
+	for (auto &&it : c.mergedArenas)
+		mergedArenas.Add(it);
+
 	HashMap<NamedScope *, NamedScope *> scopeRemap;
 
 	if (progList.IsEmpty())
@@ -1087,6 +1099,8 @@ bool Compiler::AddCompiledProgram(AstNode *node)
 {
 	LETHE_RET_FALSE(node);
 
+	AstArenaScope arenaScope(astArena);
+
 	if (progList.IsEmpty())
 	{
 		TokenLocation loc;
@@ -1264,6 +1278,8 @@ bool Compiler::Resolve(bool ignoreErrors)
 {
 	LETHE_RET_FALSE(progList);
 
+	AstArenaScope arenaScope(astArena);
+
 	ErrorHandler eh;
 	InjectScopes(eh);
 
@@ -1414,11 +1430,154 @@ bool Compiler::Resolve(bool ignoreErrors)
 }
 
 bool Compiler::CodeGen(CompiledProgram &p)
+{
+	AstArenaScope arenaScope(astArena);
+	auto res = CodeGenInternal(p);
+	// late delete nodes may come from our arena, so they must not outlive us
+	p.FlushLateDeleteNodes();
+	return res;
+}
+
+void Compiler::StripUnreferencedFuncs(const CompiledProgram &p)
+{
+	// only plain script functions can be stripped; virtual methods, ctors/dtors, operators
+	// and internal __ functions (property accessors, __init, __copy, ...) are called implicitly
+	// note: no type-level reachability; hosts can instantiate any class by name, so every
+	// virtual method stays a root and no types are removed
+	auto canStrip = [](const AstNode *n) -> bool
+	{
+		if (n->type != AST_FUNC || n->nodes.GetSize() <= AstFunc::IDX_BODY)
+			return false;
+
+		if (n->qualifiers & (AST_Q_NATIVE | AST_Q_VIRTUAL | AST_Q_OVERRIDE | AST_Q_CTOR | AST_Q_DTOR |
+			AST_Q_STATE | AST_Q_STATEBREAK | AST_Q_LATENT))
+		{
+			return false;
+		}
+
+		const auto *fname = n->nodes[AstFunc::IDX_NAME];
+
+		if (fname->type != AST_IDENT || (fname->qualifiers & AST_Q_OPERATOR))
+			return false;
+
+		return !AstStaticCast<const AstText *>(fname)->text.StartsWith("__");
+	};
+
+	HashSet<const AstNode *> reached;
+	Array<const AstNode *> stk;
+
+	AstNode *n;
+
+	for (AstIterator it(progList); (n = it.Next()) != nullptr;)
+	{
+		if (!canStrip(n) || p.keepFuncs.FindIndex(AstStaticCast<const AstText *>(n->nodes[AstFunc::IDX_NAME])->GetQTextSlow()) < 0)
+			continue;
+
+		reached.Add(n);
+		stk.Add(n);
+	}
+
+	// everything outside of strippable functions is a root
+	stk.Add(progList);
+
+	while (!stk.IsEmpty())
+	{
+		const auto *cur = stk.Back();
+		stk.Pop();
+
+		const auto *targ = cur->target;
+
+		if (targ && canStrip(targ) && reached.FindIndex(targ) < 0)
+		{
+			reached.Add(targ);
+			stk.Add(targ);
+		}
+
+		for (const auto *it : cur->nodes)
+		{
+			// strippable functions are only visited once reached
+			if (!canStrip(it))
+				stk.Add(it);
+		}
+	}
+
+	for (AstIterator it(progList); (n = it.Next()) != nullptr;)
+	{
+		if (!canStrip(n) || reached.FindIndex(n) >= 0)
+			continue;
+
+		n->flags |= AST_F_SKIP_CGEN;
+		n->qualifiers &= ~AST_Q_FUNC_REFERENCED;
+	}
+}
+
+void Compiler::MarkNativeLayoutTypes(CompiledProgram &p)
+{
+	// structs/classes seen by native code must keep declaration order
+	Array<const AstNode *> stk;
+
+	auto addType = [&](const AstNode *targ)
+	{
+		while (targ && targ->type == AST_TYPEDEF)
+			targ = targ->GetTypeNode();
+
+		if (!targ || (targ->type != AST_STRUCT && targ->type != AST_CLASS) || p.nativeLayoutTypes.FindIndex(targ) >= 0)
+			return;
+
+		p.nativeLayoutTypes.Add(targ);
+		stk.Add(targ);
+	};
+
+	// type node may be composite (arrays, templates)
+	auto addTypes = [&](const AstNode *typeNode)
+	{
+		const AstNode *n;
+
+		for (AstConstIterator it(typeNode); (n = it.Next()) != nullptr;)
+			addType(n->target);
+	};
+
+	AstNode *n;
+
+	for (AstIterator it(progList); (n = it.Next()) != nullptr;)
+	{
+		if (n->type == AST_FUNC && (n->qualifiers & AST_Q_NATIVE))
+		{
+			addTypes(n->nodes[0]);
+
+			for (const auto *arg : n->nodes[AstFunc::IDX_ARGS]->nodes)
+				if (arg->type == AST_ARG)
+					addTypes(arg->nodes[0]);
+		}
+		else if (n->type == AST_VAR_DECL_LIST && (n->nodes[0]->qualifiers & AST_Q_NATIVE))
+			addTypes(n->nodes[0]);
+	}
+
+	// members and bases of native-visible types are visible too
+	while (!stk.IsEmpty())
+	{
+		const auto *cur = stk.Back();
+		stk.Pop();
+
+		if (cur->scopeRef && cur->scopeRef->base && cur->scopeRef->base->node)
+			addType(cur->scopeRef->base->node);
+
+		for (const auto *it : cur->nodes)
+			if (it->type == AST_VAR_DECL_LIST && !(it->nodes[0]->qualifiers & AST_Q_STATIC))
+				addTypes(it->nodes[0]);
+	}
+}
+
+bool Compiler::CodeGenInternal(CompiledProgram &p)
 {
 	InjectScopes(p);
 
 	LETHE_RET_FALSE(progList);
 
+	// before anything can generate types (sizeof folding)
+	if (p.FieldReorderingEnabled())
+		MarkNativeLayoutTypes(p);
+
 	LETHE_RET_FALSE(progList->BeginCodegen(p));
 
 	p.foldSizeof = false;
@@ -1426,6 +1585,12 @@ bool Compiler::CodeGen(CompiledProgram &p)
 	p.foldSizeof = true;
 	while (progList->FoldConst(p));
 
+	if (p.stripUnreferenced)
+		StripUnreferencedFuncs(p);
+
+	if (p.StackObjectsAllowed())
+		MarkStackObjects();
+
 	LETHE_RET_FALSE(progList->TypeGenDef(p));
 	LETHE_RET_FALSE(progList->TypeGen(p));
 	// generate ctors/dtors/assignment for composite types
@@ -1442,11 +1607,28 @@ bool Compiler::CodeGen(CompiledProgram &p)
 
 	p.Optimize();
 	p.FixupVtbl();
+
+	if (!p.cpool.SealReadOnlyData())
+		return p.Error(progList, "cannot allocate read-only data");
+
 	return 1;
 }
 
+size_t Compiler::GetAstArenaUsage() const
+{
+	size_t res = astArena->GetUsage();
+
+	for (auto &&it : mergedArenas)
+		res += it->GetUsage();
+
+	return res;
+}
+
 void Compiler::Clear()
 {
+	// keep arenas alive until old AST is gone, then free in one go
+	auto oldArena = astArena;
+	auto oldMergedArenas = mergedArenas;
 	*this = Compiler();
 }
 
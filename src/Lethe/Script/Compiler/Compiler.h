@@ -93,6 +93,9 @@ public:
 	// inject array/string scopes
 	void InjectScopes(ErrorHandler &eh);
 
+	// memory allocated in AST arenas
+	size_t GetAstArenaUsage() const;
+
 private:
 	static const Int MAX_DEPTH = 1024;
 
@@ -166,6 +169,11 @@ private:
 		NamedScope *oldScope;
 	};
 
+	// AST arena; must be declared before anything holding AST nodes
+	SharedPtr<ArenaAlloc> astArena;
+	// arenas of merged compilers
+	Array<SharedPtr<ArenaAlloc>> mergedArenas;
+
 	TokenMacroMap macroMap;
 
 	HashSet< String > stringTable;
@@ -219,6 +227,13 @@ private:
 
 	bool OpenBuffered(Stream &s, const String &nfilename, Double *ioTime);
 	AstNode *CompileInternal(bool nbuffered, Stream &s, const String &nfilename, Double *ioTime);
+	bool CodeGenInternal(CompiledProgram &p);
+	// mark functions unreachable from roots as skipped
+	void StripUnreferencedFuncs(const CompiledProgram &p);
+	// collect types used in native signatures/vars (field reordering must skip them)
+	void MarkNativeLayoutTypes(CompiledProgram &p);
+	// mark local vars initialized via non-escaping new to allocate objects in stack frame
+	void MarkStackObjects();
 
 	bool MacroExpandProgram(const String &nfilename);
 
@@ -257,6 +257,13 @@ AstNode *Compiler::ParseFuncDecl(UniquePtr<AstNode> &ntype, UniquePtr<AstNode> &
 		ntype->qualifiers &= ~AST_Q_FUNC_MASK;
 	}
 
+	// constexpr applies to func, not to result
+	if (ntype->qualifiers & AST_Q_CONSTEXPR)
+	{
+		fqualifiers |= AST_Q_CONSTEXPR;
+		ntype->qualifiers &= ~(AST_Q_CONST | AST_Q_CONSTEXPR);
+	}
+
 	// now get ready to parse the most important one: function body
 	// this is where all code resides
 
@@ -0,0 +1,216 @@
+#include "Compiler.h"
+
+#include "AstIncludes.h"
+
+#include <Lethe/Script/Program/CompiledProgram.h>
+
+namespace lethe
+{
+
+// escape analysis for local objects created via new:
+// object doesn't escape if the pointer is only used to access members or call methods,
+// which in turn only use this to access members or call such methods
+
+// method summaries for one class: true if this doesn't escape
+typedef HashMap<const AstNode *, bool> EscapeSummary;
+
+static bool Escape_IsThisSafe(const AstNode *root, const NamedScope *cls, EscapeSummary &summary);
+
+// find method actually called on object of exact class cls
+static const AstNode *Escape_FindMethod(const AstNode *fn, const NamedScope *cls)
+{
+	const auto *fname = fn->nodes[AstFunc::IDX_NAME];
+
+	if (fname->type != AST_IDENT)
+		return nullptr;
+
+	return cls->FindSymbol(AstStaticCast<const AstText *>(fname)->text, true);
+}
+
+static bool Escape_IsMethodSafe(const AstNode *fn, const NamedScope *cls, EscapeSummary &summary)
+{
+	auto it = summary.Find(fn);
+
+	if (it != summary.End())
+		return it->value;
+
+	// optimistic for recursion; any failure makes the whole query fail anyway
+	summary[fn] = true;
+
+	bool res = fn->type == AST_FUNC && fn->nodes.GetSize() > AstFunc::IDX_BODY &&
+		!(fn->qualifiers & (AST_Q_NATIVE | AST_Q_STATE | AST_Q_STATEBREAK | AST_Q_LATENT)) &&
+		Escape_IsThisSafe(fn->nodes[AstFunc::IDX_BODY], cls, summary);
+
+	summary[fn] = res;
+	return res;
+}
+
+// dot with object on the left
+static bool Escape_IsMemberAccessSafe(const AstNode *dot, const NamedScope *cls, EscapeSummary &summary)
+{
+	const auto *targ = dot->nodes[1]->target;
+
+	if (!targ)
+		return false;
+
+	if (targ->type == AST_VAR_DECL)
+		return !(targ->qualifiers & AST_Q_PROPERTY);
+
+	if (targ->type != AST_FUNC)
+		return false;
+
+	// method must be called directly, binding a delegate leaks the object
+	const auto *call = dot->parent;
+	LETHE_RET_FALSE(call && call->type == AST_CALL && call->nodes[0] == dot);
+
+	if (targ->qualifiers & AST_Q_STATIC)
+		return true;
+
+	const auto *fn = Escape_FindMethod(targ, cls);
+	return fn && Escape_IsMethodSafe(fn, cls, summary);
+}
+
+static bool Escape_IsImplicitThisSafe(const AstNode *n, const NamedScope *cls, EscapeSummary &summary)
+{
+	const auto *targ = n->target;
+
+	// member vars are always fine, only non-static methods take this
+	if (!targ || targ->type != AST_FUNC || (targ->qualifiers & AST_Q_STATIC) || !targ->scopeRef || !targ->scopeRef->FindThis(true))
+		return true;
+
+	// explicit object; this on the left is checked separately
+	if (n->parent && n->parent->type == AST_OP_DOT && n->parent->nodes[1] == n)
+		return true;
+
+	const auto *call = n->parent;
+	LETHE_RET_FALSE(call && call->type == AST_CALL && call->nodes[0] == n);
+
+	const auto *fn = Escape_FindMethod(targ, cls);
+	return fn && Escape_IsMethodSafe(fn, cls, summary);
+}
+
+static bool Escape_IsThisSafe(const AstNode *root, const NamedScope *cls, EscapeSummary &summary)
+{
+	const AstNode *n;
+
+	for (AstConstIterator it(root); (n = it.Next()) != nullptr;)
+	{
+		switch(n->type)
+		{
+		case AST_FUNC:
+		case AST_SUPER:
+			// nested functions, non-virtual base calls
+			return false;
+
+		case AST_THIS:
+			LETHE_RET_FALSE(n->parent && n->parent->type == AST_OP_DOT && n->parent->nodes[0] == n);
+			LETHE_RET_FALSE(Escape_IsMemberAccessSafe(n->parent, cls, summary));
+			break;
+
+		case AST_IDENT:
+			LETHE_RET_FALSE(Escape_IsImplicitThisSafe(n, cls, summary));
+			break;
+
+		default:;
+		}
+	}
+
+	return true;
+}
+
+// ctors, dtors and member initializers of class and its bases
+static bool Escape_IsClassSafe(const AstNode *clsNode, EscapeSummary &summary)
+{
+	const auto *cls = clsNode->scopeRef;
+	LETHE_RET_FALSE(cls && !(clsNode->qualifiers & (AST_Q_NATIVE | AST_Q_STATE)));
+
+	for (const auto *scope = cls; scope; scope = scope->base)
+	{
+		const auto *node = scope->node;
+		LETHE_RET_FALSE(node && node->type == AST_CLASS);
+
+		// only root object may be native
+		if (node->qualifiers & AST_Q_NATIVE)
+		{
+			LETHE_RET_FALSE(!scope->base);
+			continue;
+		}
+
+		for (const auto *it : node->nodes)
+		{
+			if (it->type == AST_FUNC && (it->qualifiers & (AST_Q_CTOR | AST_Q_DTOR)))
+				LETHE_RET_FALSE(Escape_IsMethodSafe(it, cls, summary));
+
+			if (it->type != AST_VAR_DECL_LIST)
+				continue;
+
+			for (Int i=1; i<it->nodes.GetSize(); i++)
+			{
+				const auto *vdecl = it->nodes[i];
+
+				if (vdecl->nodes.GetSize() > 1)
+					LETHE_RET_FALSE(Escape_IsThisSafe(vdecl->nodes[1], cls, summary));
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool Escape_IsLocalSafe(const AstNode *vdecl, const NamedScope *cls, EscapeSummary &summary)
+{
+	const AstNode *fn = vdecl->parent;
+
+	while (fn && fn->type != AST_FUNC)
+		fn = fn->parent;
+
+	// latent functions may outlive the frame
+	LETHE_RET_FALSE(fn && !(fn->qualifiers & (AST_Q_STATE | AST_Q_STATEBREAK | AST_Q_LATENT)));
+
+	const AstNode *n;
+
+	for (AstConstIterator it(fn); (n = it.Next()) != nullptr;)
+	{
+		if (n->target != vdecl || n == vdecl->nodes[0])
+			continue;
+
+		LETHE_RET_FALSE(n->type == AST_IDENT && n->parent && n->parent->type == AST_OP_DOT && n->parent->nodes[0] == n);
+
+		// deferred statements run while leaving scope, keep it simple
+		for (const auto *tmp = n->parent; tmp && tmp != fn; tmp = tmp->parent)
+			LETHE_RET_FALSE(tmp->type != AST_DEFER && tmp->type != AST_FUNC);
+
+		LETHE_RET_FALSE(Escape_IsMemberAccessSafe(n->parent, cls, summary));
+	}
+
+	return true;
+}
+
+void Compiler::MarkStackObjects()
+{
+	AstNode *n;
+
+	for (AstIterator it(progList); (n = it.Next()) != nullptr;)
+	{
+		if (n->type != AST_VAR_DECL || n->nodes.GetSize() < 2 || n->nodes[1]->type != AST_NEW)
+			continue;
+
+		if (!n->scopeRef || !n->scopeRef->IsLocal() || (n->qualifiers & AST_Q_STATIC) ||
+			(n->parent->nodes[0]->qualifiers & (AST_Q_STATIC | AST_Q_REFERENCE | AST_Q_WEAK | AST_Q_RAW)))
+		{
+			continue;
+		}
+
+		const auto *clsNode = AstStaticCast<const AstUnaryNew *>(n->nodes[1])->GetClassNode();
+
+		if (!clsNode)
+			continue;
+
+		EscapeSummary summary;
+
+		if (Escape_IsClassSafe(clsNode, summary) && Escape_IsLocalSafe(n, clsNode->scopeRef, summary))
+			n->flags |= AST_F_STACK_OBJECT;
+	}
+}
+
+}
@@ -1127,7 +1127,6 @@ AstNode *Compiler::ParseAssignExpression(Int depth)
 			return res.Detach();
 		}
 
-		TokenLocation nloc = t.location;
 		ts->ConsumeToken();
 		UniquePtr<AstNode> tmp = ntype == AST_OP_TERNARY ? ParseExpression(depth+1) :
 			ts->PeekToken().type == TOK_LBLOCK ? ParseAnonStructLiteral(depth+1) :  ParseLOrExpression(depth+1);
@@ -5,6 +5,7 @@
 #include <Lethe/Script/Ast/CodeGenTables.h>
 #include <Lethe/Script/Ast/NamedScope.h>
 #include <Lethe/Script/Ast/ControlFlow/AstLabel.h>
+#include <Lethe/Script/Ast/Function/AstFunc.h>
 #include <Lethe/Script/Vm/Stack.h>
 #include <Lethe/Script/Vm/Builtin.h>
 #include "../ScriptEngine.h"
@@ -26,7 +27,7 @@ void ErrorHandler::CheckShadowing(const NamedScope *cscope, const String &nname,
 
 			if (sym && (sym->type == AST_VAR_DECL || sym->type == AST_ARG))
 			{
-				Path pth = sym->location.file;
+				Path pth = sym->location.file.Get();
 				onWarn(
 					String::Printf("declaration of %s shadows a previous variable at line %d in %s", nname.Ansi(), sym->location.line, pth.GetFilename().Ansi()),
 					nnode->location, WARN_SHADOW);
@@ -501,6 +502,56 @@ bool CompiledProgram::ReturnScope(bool retOpt)
 	return false;
 }
 
+bool CompiledProgram::CanTailCallScope() const
+{
+	const NamedScope *cscope = curScope;
+
+	for (Int i=scopeStack.GetSize()-1; i>=0; i--)
+	{
+		// deferred statements may still read args
+		if (!cscope->deferred.IsEmpty())
+			return false;
+
+		if (cscope->type == NSCOPE_FUNCTION)
+			return true;
+
+		cscope = scopeStack[i].oldScope;
+	}
+
+	return false;
+}
+
+bool CompiledProgram::TailCallScope()
+{
+	NamedScope *cscope = curScope;
+
+	auto oexprStackOfs = exprStackOfs;
+	LETHE_DEFER(exprStackOfs = oexprStackOfs);
+
+	for (Int i=scopeStack.GetSize()-1; i>=0; i--)
+	{
+		ScopeDesc sd = scopeStack[i];
+
+		Int vofsBase = sd.varOfsBase;
+
+		if (cscope->varOfs != vofsBase)
+		{
+			cscope->GenDestructors(*this);
+			Emit(OPC_POP + (UInt((cscope->varOfs - vofsBase)/Stack::WORD_SIZE) << 8));
+			exprStackOfs -= cscope->varOfs - vofsBase;
+		}
+
+		// function body scope starts right after args
+		if (cscope->type == NSCOPE_FUNCTION)
+			return true;
+
+		cscope = sd.oldScope;
+	}
+
+	LETHE_ASSERT(false && "broken tail call");
+	return false;
+}
+
 bool CompiledProgram::LeaveScope(bool virt)
 {
 	ScopeDesc sd = scopeStack.Back();
@@ -585,6 +636,7 @@ bool CompiledProgram::FixupForwardTarget(Int fwHandle)
 		instructions.Back() = OPC_NOP;
 		// new: don't flush opt for br 0
 		flist.Free(fwHandle);
+		fixupTargets[fwHandle] = -1;
 		return 1;
 	}
 	else
@@ -631,6 +683,7 @@ bool CompiledProgram::FixupForwardTarget(Int fwHandle)
 	}
 
 	flist.Free(fwHandle);
+	fixupTargets[fwHandle] = -1;
 
 	// this helps JIT keep some regs cached when falling through
 	// (preparing for loop unrolling)
@@ -684,6 +737,16 @@ bool CompiledProgram::IsCondJump(Int ins)
 	return opc > OPC_BR && opc <= OPC_PCMPNZ;
 }
 
+bool CompiledProgram::IsRelativeJump(Int ins)
+{
+	auto opc = ins & 255;
+
+	if (opc == OPC_CALL || opc == OPC_PUSH_FUNC)
+		return true;
+
+	return (opc >= OPC_ICMPNZ_BZ && opc <= OPC_DCMPNZ_BNZ) || (opc >= OPC_BR && opc <= OPC_DBGE);
+}
+
 bool CompiledProgram::IsCondJumpNoFloat(Int ins)
 {
 	LETHE_RET_FALSE(IsCondJump(ins));
@@ -912,7 +975,7 @@ void CompiledProgram::AddReturnHandle(Int handle)
 	returnHandles.Add(handle);
 }
 
-bool CompiledProgram::FixupHandles(Array<Int> &handles)
+bool CompiledProgram::FixupHandles(Array<Int> &handles, Array<Int> *targets)
 {
 	auto cmp = [this](int x, int y) -> bool
 	{
@@ -921,7 +984,12 @@ bool CompiledProgram::FixupHandles(Array<Int> &handles)
 	handles.Sort(cmp);
 
 	for (Int i=handles.GetSize()-1; i>=0; i--)
+	{
+		if (targets)
+			targets->Add(fixupTargets[handles[i]]);
+
 		LETHE_RET_FALSE(FixupForwardTarget(handles[i]));
+	}
 
 	handles.Clear();
 	return 1;
@@ -1038,6 +1106,15 @@ bool CompiledProgram::EmitGlobalCopy(AstNode *n, const DataType &src, Int offset
 	return true;
 }
 
+void CompiledProgram::EmitReadOnlyAdr(Int offset)
+{
+	LETHE_ASSERT(cpool.roDataSlot >= 0 && CanEncodeI24(offset));
+	EmitU24(OPC_GLOADPTR, cpool.roDataSlot);
+
+	if (offset)
+		EmitI24(OPC_AADD_ICONST, offset);
+}
+
 void CompiledProgram::EmitLocalDtor(const DataType &src, Int offset)
 {
 	Int delta = offset;
@@ -1381,4 +1458,144 @@ bool CompiledProgram::IsSwitchTable(Int pc) const
 	return isSwitchTable;
 }
 
+bool CompiledProgram::HasPendingFixups(Int start, Int end) const
+{
+	for (auto target : fixupTargets)
+		if (target >= start && target < end)
+			return true;
+
+	return false;
+}
+
+ULong CompiledProgram::GetFoldIns(const FoldBody &body, Int pc) const
+{
+	ULong res = (UInt)instructions[pc];
+
+	if (IsSwitchTable(pc))
+		return res | ((ULong)1 << 63);
+
+	if (!IsRelativeJump(instructions[pc]))
+		return res;
+
+	// internal targets are relative to function start, external targets are absolute
+	Int target = pc + (instructions[pc] >> 8) + 1;
+	res &= 255;
+
+	if (target >= body.start && target <= body.end)
+		return res | ((ULong)(UInt)(target - body.start) << 32);
+
+	return res | 256 | ((ULong)(UInt)target << 32);
+}
+
+UInt CompiledProgram::HashFoldBody(const FoldBody &body) const
+{
+	UInt res = HashUInt(UInt(body.end - body.start));
+
+	for (Int i=body.start; i<body.end; i++)
+		res = HashMerge(res, HashULong(GetFoldIns(body, i)));
+
+	return res;
+}
+
+bool CompiledProgram::FoldBodyEqual(const FoldBody &a, const FoldBody &b) const
+{
+	LETHE_RET_FALSE(a.end - a.start == b.end - b.start);
+
+	for (Int i=0; i<a.end - a.start; i++)
+		LETHE_RET_FALSE(GetFoldIns(a, a.start + i) == GetFoldIns(b, b.start + i));
+
+	// line info must match as well so that breakpoints still work
+	CodeToLine lookup;
+	lookup.pc = a.start;
+	auto ia = LowerBound(codeToLine.Begin(), codeToLine.End(), lookup);
+	lookup.pc = b.start;
+	auto ib = LowerBound(codeToLine.Begin(), codeToLine.End(), lookup);
+
+	for (; ia != codeToLine.End() && ia->pc < a.end; ++ia, ++ib)
+	{
+		LETHE_RET_FALSE(ib != codeToLine.End() && ib->pc < b.end);
+		LETHE_RET_FALSE(ia->pc - a.start == ib->pc - b.start && ia->line == ib->line && ia->file == ib->file);
+	}
+
+	return ib == codeToLine.End() || ib->pc >= b.end;
+}
+
+void CompiledProgram::DiscardCode(Int pc)
+{
+	instructions.Resize(pc);
+
+	while (!codeToLine.IsEmpty() && codeToLine.Back().pc >= pc)
+		codeToLine.Pop();
+
+	while (!barriers.IsEmpty() && barriers.Back() >= pc)
+		barriers.Pop();
+
+	while (!loops.IsEmpty() && loops.Back() >= pc)
+		loops.Pop();
+
+	while (!switchRange.IsEmpty() && switchRange.Back() >= pc)
+		switchRange.Pop();
+
+	for (auto it = localVars.Begin(); it != localVars.End();)
+	{
+		if (it->value.startPC >= pc)
+			it = localVars.Erase(it);
+		else
+			++it;
+	}
+
+	if (lastForwardJump >= pc)
+		lastForwardJump = -1;
+
+	jumpOptBase = Min(jumpOptBase, pc);
+	emitOptBase = pc;
+	FlushOpt();
+}
+
+Int CompiledProgram::FoldIdenticalFunc(Int startPC, const Array<Int> &callers)
+{
+	FoldBody body;
+	body.start = startPC;
+	body.end = instructions.GetSize();
+
+	// calls to functions not generated yet can't be compared
+	if (body.start >= body.end || HasPendingFixups(body.start, body.end))
+		return -1;
+
+	auto &bodies = foldBodies[HashFoldBody(body)];
+
+	for (auto &&it : bodies)
+	{
+		if (!FoldBodyEqual(it, body))
+			continue;
+
+		Int canon = it.start;
+
+		auto fit = funcMap.Find(startPC);
+
+		if (fit != funcMap.End())
+		{
+			auto &fd = functions.GetValue(fit->value);
+			fd.adr = canon;
+
+			if (fd.node)
+				fd.node->offset = canon;
+
+			funcMap.Erase(fit);
+		}
+
+		for (auto pc : callers)
+		{
+			auto &ins = instructions[pc];
+			ins = (ins & 255) + ((UInt)(canon - pc - 1) << 8);
+		}
+
+		DiscardCode(startPC);
+		return canon;
+	}
+
+	bodies.Add(body);
+	return -1;
+}
+
 }
@@ -164,6 +164,10 @@ public:
 	// leave scope chain using return
 	// returns true if we can return immediately
 	bool ReturnScope(bool retOpt = 1);
+	// can leave scope chain before a tail call? (no deferred statements)
+	bool CanTailCallScope() const;
+	// leave scope chain before a tail call, keeping function args
+	bool TailCallScope();
 	// emit cleanup & return from state via statebreak method call
 	bool StateBreakScope();
 	// leave scope chain using goto
@@ -180,6 +184,8 @@ public:
 	bool EmitConv(AstNode *n, const QDataType &src, const QDataType &dstq, bool warn = true);
 	bool EmitGlobalCopy(AstNode *n, const DataType &src, Int offset);
 	bool EmitGlobalDtor(AstNode *n, const DataType &src, Int offset);
+	// push address into read-only data
+	void EmitReadOnlyAdr(Int offset);
 	void EmitLocalDtor(const DataType &src, Int offset);
 
 	// special I24 version
@@ -229,7 +235,8 @@ public:
 		return jitFriendly;
 	}
 
-	bool FixupHandles(Array<Int> &handles);
+	// optionally collects fixed up instruction indices
+	bool FixupHandles(Array<Int> &handles, Array<Int> *targets = nullptr);
 	bool FixupReturnHandles();
 	inline Array<Int> &GetReturnHandles() {return returnHandles;}
 
@@ -305,6 +312,31 @@ public:
 	{
 		return inlineExpansionAllowed;
 	}
+	bool StackObjectsAllowed() const
+	{
+		// heap profiler must see every new
+		return stackObjectsAllowed && !HeapProfilingEnabled();
+	}
+	bool RefCountElisionAllowed() const
+	{
+		return refCountElisionAllowed;
+	}
+	bool TailCallsAllowed() const
+	{
+		return tailCallsAllowed && !inlineCall && !profiling;
+	}
+	bool ReadOnlyDataAllowed() const
+	{
+		return readOnlyDataAllowed;
+	}
+	bool FieldReorderingEnabled() const
+	{
+		return fieldReordering;
+	}
+	bool HeapProfilingEnabled() const
+	{
+		return cpool.heapProfiler != nullptr;
+	}
 
 	static bool IsConvToBool(Int ins);
 
@@ -319,6 +351,8 @@ public:
 	Int exprStackOfs;
 	// extra offset because of nrvo and initializer lists
 	Int initializerDelta;
+	// bake global initializers into read-only data
+	bool bakeReadOnly = false;
 
 	// index of last forward jump, -1 if none
 	Int lastForwardJump;
@@ -336,6 +370,21 @@ public:
 	// native function map (temporary)
 	HashMap<String, AstNode *> nativeMap;
 
+	// strip unreferenced functions at link time; keep list uses fully qualified names
+	bool stripUnreferenced = false;
+	HashSet<String> keepFuncs;
+
+	// types passed to/from native code; not reordered by EnableFieldReordering
+	HashSet<const AstNode *> nativeLayoutTypes;
+
+	// identical code folding of template instance functions
+	bool foldIdenticalFuncs = false;
+
+	// try to merge function body emitted since startPC with an identical body generated before
+	// callers are forward call sites already fixed up to startPC
+	// returns canonical address (body is discarded) or -1 if not folded
+	Int FoldIdenticalFunc(Int startPC, const Array<Int> &callers);
+
 	struct LocalVarDebugKey
 	{
 		// scope index
@@ -462,6 +511,15 @@ private:
 	// vtables (index, count) pairs
 	Array<Int> vtbls;
 
+	struct FoldBody
+	{
+		Int start;
+		Int end;
+	};
+
+	// identical code folding candidates by body hash
+	HashMap<UInt, Array<FoldBody>> foldBodies;
+
 	struct GlobalDestFixup
 	{
 		Int target;
@@ -487,6 +545,16 @@ private:
 	bool profiling;
 	// can be disabled via ScriptEngine
 	bool inlineExpansionAllowed = true;
+	// place non-escaping objects in stack frame; can be disabled via ScriptEngine
+	bool stackObjectsAllowed = true;
+	// borrow references for local strong ptrs where possible; can be disabled via ScriptEngine
+	bool refCountElisionAllowed = true;
+	// jump to function in tail position instead of call; can be disabled via ScriptEngine
+	bool tailCallsAllowed = true;
+	// place constant globals in shared read-only data; can be disabled via ScriptEngine
+	bool readOnlyDataAllowed = true;
+	// reorder struct/class fields by alignment; off by default, can be enabled via ScriptEngine
+	bool fieldReordering = false;
 	// set before inline call
 	Int inlineCall;
 
@@ -516,6 +584,7 @@ private:
 	void EmitInternal(UInt ins);
 
 	static bool IsCondJump(Int ins);
+	static bool IsRelativeJump(Int ins);
 	static bool IsCondJumpNoFloat(Int ins);
 	static Int FlipJump(Int ins);
 
@@ -527,6 +596,13 @@ private:
 	bool CanEncodeI24(Int val) const;
 
 	bool EmitDefer(NamedScope *cscope, Int nstart = 0);
+
+	// identical code folding helpers
+	bool HasPendingFixups(Int start, Int end) const;
+	ULong GetFoldIns(const FoldBody &body, Int pc) const;
+	UInt HashFoldBody(const FoldBody &body) const;
+	bool FoldBodyEqual(const FoldBody &a, const FoldBody &b) const;
+	void DiscardCode(Int pc);
 };
 
 LETHE_API_END
@@ -141,7 +141,7 @@ Int CompiledProgram::EmitForwardJump(UInt ins)
 	Int nsize = handle+1;
 
 	if (handle >= fixupTargets.GetSize())
-		fixupTargets.Resize(nsize);
+		fixupTargets.Resize(nsize, -1);
 
 	fixupTargets[handle] = fixupTarget;
 	lastForwardJump = fixupTarget;
@@ -269,6 +269,17 @@ static const Fold2 opcFold2TableMov[] =
 	{ OPC_HALT, OPC_HALT, OPC_HALT }
 };
 
+// store + load of the same local => store without pop
+// note: peephole fold inside emitOptBase window, never crosses a jump target
+static const Fold2 opcFold2TableForward[] =
+{
+	{ OPC_LSTORE32,  OPC_LPUSH32,  OPC_LSTORE32_NP  },
+	{ OPC_LSTORE32F, OPC_LPUSH32F, OPC_LSTORE32F_NP },
+	{ OPC_LSTORE64D, OPC_LPUSH64D, OPC_LSTORE64D_NP },
+	{ OPC_LSTOREPTR, OPC_LPUSHPTR, OPC_LSTOREPTR_NP },
+	{ OPC_HALT,      OPC_HALT,     OPC_HALT         }
+};
+
 static const Fold2 opcFold2TablePLoad[] =
 {
 	{ OPC_PUSH_ICONST, OPC_PLOAD8,   OPC_PLOAD8_IMM   },
@@ -742,10 +753,52 @@ void CompiledProgram::EmitInternal(UInt ins)
 
 		break;
 
+	case OPC_LPUSH32:
+	case OPC_LPUSH32F:
+	case OPC_LPUSH64D:
+	case OPC_LPUSHPTR:
+		for (const Fold2 *f2 = opcFold2TableForward; num > 0 && emitOptBase <= num-1 && f2->opc0 != OPC_HALT; f2++)
+		{
+			// fold LSTORE32 x + LPUSH32 x => LSTORE32_NP x (value is still on stack)
+			if (opc != (UInt)f2->opc1 || GetInsType(num-1) != f2->opc0)
+				continue;
+
+			Int words = opc == OPC_LPUSH64D ? (Int)Stack::DOUBLE_WORDS : 1;
+
+			if (GetInsImm24(num-1) - words != (Int)(ins >> 8))
+				continue;
+
+			instructions[num-1] = f2->opcFold + ((UInt)GetInsImm24(num-1) << 8);
+			return;
+		}
+
+		break;
+
 	case OPC_PUSH_RAW:
 	case OPC_PUSHZ_RAW:
 	case OPC_POP:
 
+		// fold LSTORE32_NP + POP => LSTORE32 (and similar)
+		for (const Fold2 *f2 = opcFold2TableForward; opc == OPC_POP && num > 0 && emitOptBase <= num-1 && f2->opc0 != OPC_HALT; f2++)
+		{
+			if (GetInsType(num-1) != f2->opcFold)
+				continue;
+
+			Int words = f2->opc0 == OPC_LSTORE64D ? (Int)Stack::DOUBLE_WORDS : 1;
+			Int amt = (Int)(ins >> 8);
+
+			if (amt < words)
+				break;
+
+			instructions[num-1] = f2->opc0 + ((UInt)GetInsImm24(num-1) << 8);
+
+			if (amt == words)
+				return;
+
+			ins = OPC_POP + ((UInt)(amt - words) << 8);
+			break;
+		}
+
 		// optimize sequence of PUSH_RAW/PUSHZ_RAW/POP
 		if (num > 0 && emitOptBase <= num-1)
 		{
@@ -1,4 +1,6 @@
 #include "ConstPool.h"
+#include "ReadOnlyData.h"
+#include "HeapProfiler.h"
 #include <Lethe/Script/TypeInfo/DataTypes.h>
 #include <Lethe/Script/Vm/Builtin.h>
 #include <Lethe/Core/Math/Math.h>
@@ -19,6 +21,9 @@ ConstPool::~ConstPool()
 	// clean up
 	for (auto ofs : globalBakedStrings)
 		reinterpret_cast<String *>(data.GetData() + ofs)->~String();
+
+	ReadOnlyData::Release(roShared);
+	delete heapProfiler;
 }
 
 void ConstPool::Align(Int align)
@@ -39,7 +44,11 @@ Int ConstPool::AllocGlobalVar(const QDataType &dt, const String &name)
 	info.offset = res;
 	info.qualifiers = dt.qualifiers;
 	info.type = dt.ref;
-	globalVars[name] = info;
+	globalVarList.Add(info);
+
+	if (!name.IsEmpty())
+		globalVars[name] = info;
+
 	return res;
 }
 
@@ -62,6 +71,75 @@ Int ConstPool::AllocGlobal(const QDataType &dt)
 	return res;
 }
 
+bool ConstPool::CanAllocReadOnly(const QDataType &dt) const
+{
+	// must be reachable via aadd_iconst
+	return !roShared && (Long)roData.GetSize() + dt.GetSize() + dt.GetAlign() <= 8*1024*1024-1;
+}
+
+Int ConstPool::AllocReadOnly(const QDataType &dt)
+{
+	LETHE_ASSERT(CanAllocReadOnly(dt));
+
+	if (roDataSlot < 0)
+	{
+		Align((Int)sizeof(void *));
+		roDataSlot = data.GetSize();
+		data.Resize(roDataSlot + (Int)sizeof(void *));
+		MemSet(data.GetData() + roDataSlot, 0, sizeof(void *));
+	}
+
+	Int align = Max<Int>(dt.GetAlign(), 1);
+	Int res = roData.GetSize();
+	res += (align - res%align) % align;
+	Int fillFrom = roData.GetSize();
+	roData.Resize(res + dt.GetSize());
+	MemSet(roData.GetData() + fillFrom, 0, (size_t)roData.GetSize() - fillFrom);
+	return res;
+}
+
+Int ConstPool::AllocReadOnlyVar(const QDataType &dt, const String &name)
+{
+	auto res = AllocReadOnly(dt);
+
+	if (!name.IsEmpty())
+	{
+		GlobalVarInfo info;
+		info.offset = res;
+		info.qualifiers = dt.qualifiers;
+		info.type = dt.ref;
+		info.readOnly = true;
+		globalVars[name] = info;
+	}
+
+	return res;
+}
+
+bool ConstPool::SealReadOnlyData()
+{
+	if (roShared || roData.IsEmpty())
+		return true;
+
+	roShared = ReadOnlyData::Acquire(roData.GetData(), roData.GetSize());
+	LETHE_RET_FALSE(roShared);
+
+	const Byte *ptr = roShared->GetData();
+	MemCpy(data.GetData() + roDataSlot, &ptr, sizeof(ptr));
+
+	roData.Reset();
+	return true;
+}
+
+const Byte *ConstPool::GetReadOnlyData() const
+{
+	return roShared ? roShared->GetData() : roData.GetData();
+}
+
+Int ConstPool::GetReadOnlyDataSize() const
+{
+	return roShared ? roShared->GetSize() : roData.GetSize();
+}
+
 template< typename T, typename U >
 Int ConstPool::AddElem(T val, Array<U> &vlist, HashMap<T, Int> &vmap)
 {
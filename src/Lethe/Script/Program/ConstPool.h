@@ -15,6 +15,8 @@ namespace lethe
 class Stack;
 class DataType;
 struct QDataType;
+class ReadOnlyData;
+class HeapProfiler;
 
 template<typename T>
 struct HashableFloat
@@ -96,6 +98,17 @@ public:
 	typedef void (*NativeCallback)(Stack &stk);
 	typedef const char *(*NativeCallbackTrap)(Stack &stk);
 
+	// trap builtins (BCALL_TRAP) share nFunc slots; converted via generic function pointer (round-trip safe)
+	static inline NativeCallback FromTrap(NativeCallbackTrap fn)
+	{
+		return reinterpret_cast<NativeCallback>(reinterpret_cast<void (*)()>(fn));
+	}
+
+	static inline NativeCallbackTrap ToTrap(NativeCallback fn)
+	{
+		return reinterpret_cast<NativeCallbackTrap>(reinterpret_cast<void (*)()>(fn));
+	}
+
 	// bound native functions
 	Array< NativeCallback > nFunc;
 
@@ -130,6 +143,23 @@ public:
 		return const_cast<Byte *>(data.GetData());
 	}
 
+	// read-only data for constant globals, addressed via pointer stored in global slot
+	// built during codegen, moved to shared write-protected pages by SealReadOnlyData
+	Array<Byte> roData;
+	// global slot holding read-only data pointer, -1 if none
+	Int roDataSlot = -1;
+
+	// returns false if type doesn't fit
+	bool CanAllocReadOnly(const QDataType &dt) const;
+	// returns byte offset into read-only data
+	Int AllocReadOnly(const QDataType &dt);
+	Int AllocReadOnlyVar(const QDataType &dt, const String &name);
+	// called after codegen
+	bool SealReadOnlyData();
+	// null if no read-only data
+	const Byte *GetReadOnlyData() const;
+	Int GetReadOnlyDataSize() const;
+
 	void AddGlobalBakedString(Int ofs);
 	// called when running global ctors
 	void ClearGlobalBakedStrings();
@@ -161,14 +191,21 @@ public:
 		const DataType *type = nullptr;
 		// offset in global data
 		Int offset = -1;
+		// offset is in read-only data
+		bool readOnly = false;
 	};
 
 	// name => info
 	HashMap<String, GlobalVarInfo> globalVars;
+	// all global variables in allocation order (including unnamed/static)
+	Array<GlobalVarInfo> globalVarList;
 
 	// number of live script objects
 	mutable AtomicInt liveScriptObjects = 0;
 
+	// owned, null unless heap profiling is enabled
+	HeapProfiler *heapProfiler = nullptr;
+
 private:
 	HashMap<Byte, Int> bPoolMap;
 	HashMap<UShort, Int> usPoolMap;
@@ -182,6 +219,9 @@ private:
 	// offsets for global baked strings
 	Array<Int> globalBakedStrings;
 
+	// sealed read-only data
+	const ReadOnlyData *roShared = nullptr;
+
 	// maximum data alignment
 	Int dataAlign;
 
@@ -0,0 +1,598 @@
+#include "GlobalSnapshot.h"
+#include "CompiledProgram.h"
+#include "ConstPool.h"
+
+#include <Lethe/Core/Io/Stream.h>
+#include <Lethe/Core/Sys/Endian.h>
+#include <Lethe/Core/String/Name.h>
+#include <Lethe/Core/Collect/HashMap.h>
+#include <Lethe/Core/Memory/AlignedAlloc.h>
+#include <Lethe/Script/TypeInfo/DataTypes.h>
+#include <Lethe/Script/TypeInfo/BaseObject.h>
+
+namespace lethe
+{
+
+static const UInt GLOBAL_SNAPSHOT_MAGIC = 0x534e474cu;
+static const Int GLOBAL_SNAPSHOT_VERSION = 2;
+
+static bool SnapshotWriteInt(Stream &s, Int v)
+{
+	Endian::ToLittle(v);
+	return s.Write(&v, sizeof(v));
+}
+
+static bool SnapshotReadInt(Stream &s, Int &v)
+{
+	LETHE_RET_FALSE(s.Read(&v, sizeof(v)));
+	Endian::FromLittle(v);
+	return true;
+}
+
+// layout of script dynamic arrays
+struct SnapshotDynArray
+{
+	Byte *data;
+	Int size;
+	Int reserve;
+};
+
+// GlobalSnapshot::CaptureState
+
+struct GlobalSnapshot::CaptureState
+{
+	const CompiledProgram *prog = nullptr;
+	HashMap<const void *, Int> objectIndex;
+	// objects whose data is yet to be collected
+	Array<const void *> pending;
+	// strong refs to each object from within the snapshot
+	Array<Int> strongRefs;
+};
+
+// GlobalSnapshot
+
+GlobalSnapshot::GlobalSnapshot()
+	: dataSize(0)
+{
+}
+
+void GlobalSnapshot::Clear()
+{
+	dataSize = 0;
+	vars.Clear();
+	objects.Clear();
+	arrays.Clear();
+}
+
+bool GlobalSnapshot::IsZero(const Byte *ptr, Int size)
+{
+	for (Int i=0; i<size; i++)
+		if (ptr[i])
+			return false;
+
+	return true;
+}
+
+Int GlobalSnapshot::GetSlotSize(Int kind)
+{
+	switch(kind)
+	{
+	case SLOT_STRING:
+		return (Int)sizeof(String);
+
+	case SLOT_NAME:
+		return (Int)sizeof(Name);
+
+	case SLOT_ARRAY:
+		return (Int)sizeof(SnapshotDynArray);
+
+	default:
+		return (Int)sizeof(void *);
+	}
+}
+
+bool GlobalSnapshot::AddObject(CaptureState &cs, const void *ptr, Int &index)
+{
+	auto idx = cs.objectIndex.FindIndex(ptr);
+
+	if (idx >= 0)
+	{
+		index = cs.objectIndex.GetValue(idx);
+		return true;
+	}
+
+	const auto *obj = static_cast<const BaseObject *>(ptr);
+	const auto *cls = obj->GetScriptClassType();
+
+	// native classes hold state we can't see
+	LETHE_RET_FALSE(cls && cls->type == DT_CLASS && !(cls->structQualifiers & AST_Q_NATIVE));
+
+	Object o;
+	o.className = cls->name;
+
+	// state classes are registered under class name
+	if (cs.prog->FindClass(Name(o.className)) != cls)
+		o.className = cls->className.ToString();
+
+	LETHE_RET_FALSE(cs.prog->FindClass(Name(o.className)) == cls);
+
+	index = objects.GetSize();
+	objects.Add(o);
+	cs.objectIndex[ptr] = index;
+	cs.pending.Add(ptr);
+	cs.strongRefs.Add(0);
+	return true;
+}
+
+bool GlobalSnapshot::CollectSlots(CaptureState &cs, const DataType &dt, const Byte *ptr, Int ofs, Array<Slot> &slots)
+{
+	switch(dt.type)
+	{
+	case DT_STRING:
+	{
+		Slot slot;
+		slot.offset = ofs;
+		slot.text = *reinterpret_cast<const String *>(ptr + ofs);
+		slots.Add(slot);
+		return true;
+	}
+
+	case DT_NAME:
+	{
+		Slot slot;
+		slot.offset = ofs;
+		slot.kind = SLOT_NAME;
+		slot.text = reinterpret_cast<const Name *>(ptr + ofs)->ToString();
+		slots.Add(slot);
+		return true;
+	}
+
+	case DT_RAW_PTR:
+	case DT_WEAK_PTR:
+	case DT_STRONG_PTR:
+	{
+		const auto *obj = *reinterpret_cast<const BaseObject * const *>(ptr + ofs);
+
+		// weak refs to dead objects read as null
+		if (!obj || (dt.type == DT_WEAK_PTR && !obj->HasStrongRef()))
+			return true;
+
+		Slot slot;
+		slot.offset = ofs;
+		slot.kind = dt.type == DT_STRONG_PTR ? SLOT_STRONG : dt.type == DT_WEAK_PTR ? SLOT_WEAK : SLOT_RAW;
+		LETHE_RET_FALSE(AddObject(cs, obj, slot.index));
+
+		if (slot.kind == SLOT_STRONG)
+			cs.strongRefs[slot.index]++;
+
+		slots.Add(slot);
+		return true;
+	}
+
+	case DT_DYNAMIC_ARRAY:
+	{
+		const auto &src = *reinterpret_cast<const SnapshotDynArray *>(ptr + ofs);
+
+		if (!src.size)
+			return true;
+
+		const auto &etype = dt.elemType.GetType();
+		// SoA element layout depends on capacity
+		LETHE_RET_FALSE(!etype.IsSoa());
+
+		auto esize = dt.elemType.GetSize();
+
+		DynArray arr;
+		arr.count = src.size;
+		arr.align = etype.align;
+		arr.data.Resize(src.size * esize);
+		MemCpy(arr.data.GetData(), src.data, arr.data.GetSize());
+
+		for (Int i=0; i<src.size; i++)
+			LETHE_RET_FALSE(CollectSlots(cs, etype, arr.data.GetData(), i*esize, arr.slots));
+
+		// collected from copy, zero slots now
+		for (auto &&it : arr.slots)
+			MemSet(arr.data.GetData() + it.offset, 0, GetSlotSize(it.kind));
+
+		Slot slot;
+		slot.offset = ofs;
+		slot.kind = SLOT_ARRAY;
+		slot.index = arrays.GetSize();
+		arrays.Add(arr);
+		slots.Add(slot);
+		return true;
+	}
+
+	case DT_FUNC_PTR:
+	case DT_DELEGATE:
+	case DT_ARRAY_REF:
+		// can't relocate these, only null/empty is ok
+		return IsZero(ptr + ofs, dt.size);
+
+	case DT_STATIC_ARRAY:
+	{
+		const auto &etype = dt.elemType.GetType();
+		auto esize = dt.elemType.GetSize();
+
+		for (Int i=0; i<dt.arrayDims; i++)
+			LETHE_RET_FALSE(CollectSlots(cs, etype, ptr, ofs + i*esize, slots));
+
+		return true;
+	}
+
+	case DT_STRUCT:
+	case DT_CLASS:
+	{
+		// native structs are opaque
+		LETHE_RET_FALSE(!(dt.structQualifiers & AST_Q_NATIVE));
+
+		if (dt.baseType.GetTypeEnum() != DT_NONE)
+			LETHE_RET_FALSE(CollectSlots(cs, dt.baseType.GetType(), ptr, ofs, slots));
+
+		for (auto &&m : dt.members)
+		{
+			if (m.type.IsReference())
+			{
+				LETHE_RET_FALSE(IsZero(ptr + ofs + m.offset, (Int)sizeof(void *)));
+				continue;
+			}
+
+			LETHE_RET_FALSE(CollectSlots(cs, m.type.GetType(), ptr, ofs + (Int)m.offset, slots));
+		}
+
+		return true;
+	}
+
+	default:
+		// plain data
+		return true;
+	}
+}
+
+bool GlobalSnapshot::Capture(const CompiledProgram &prog)
+{
+	Clear();
+
+	const auto &cpool = prog.cpool;
+	const auto *gdata = cpool.GetGlobalData();
+
+	CaptureState cs;
+	cs.prog = &prog;
+
+	for (auto &&it : cpool.globalVarList)
+	{
+		Var v;
+		v.offset = it.offset;
+		v.size = it.type->size;
+		v.typeName = it.type->GetName();
+
+		if (!CollectSlots(cs, *it.type, gdata, it.offset, v.slots))
+		{
+			Clear();
+			return false;
+		}
+
+		v.data.Resize(v.size);
+		MemCpy(v.data.GetData(), gdata + v.offset, v.size);
+
+		for (auto &&slot : v.slots)
+		{
+			slot.offset -= v.offset;
+			MemSet(v.data.GetData() + slot.offset, 0, GetSlotSize(slot.kind));
+		}
+
+		vars.Add(v);
+	}
+
+	// objects found meanwhile are appended
+	for (Int i=0; i<cs.pending.GetSize(); i++)
+	{
+		const auto *obj = static_cast<const BaseObject *>(cs.pending[i]);
+		const auto *cls = obj->GetScriptClassType();
+
+		Array<Slot> slots;
+
+		if (!CollectSlots(cs, *cls, reinterpret_cast<const Byte *>(obj), 0, slots))
+		{
+			Clear();
+			return false;
+		}
+
+		auto &o = objects[i];
+		o.slots = slots;
+		o.data.Resize(cls->size);
+		MemCpy(o.data.GetData(), obj, cls->size);
+		// header is rebuilt on restore
+		MemSet(o.data.GetData(), 0, (Int)sizeof(BaseObject));
+
+		for (auto &&slot : o.slots)
+			MemSet(o.data.GetData() + slot.offset, 0, GetSlotSize(slot.kind));
+	}
+
+	// objects only kept alive from outside globals (native code) can't be restored
+	for (auto it : cs.strongRefs)
+	{
+		if (!it)
+		{
+			Clear();
+			return false;
+		}
+	}
+
+	dataSize = cpool.data.GetSize();
+	return true;
+}
+
+bool GlobalSnapshot::Validate(const CompiledProgram &prog) const
+{
+	const auto &cpool = prog.cpool;
+
+	LETHE_RET_FALSE(dataSize == cpool.data.GetSize() && vars.GetSize() == cpool.globalVarList.GetSize());
+
+	for (Int i=0; i<vars.GetSize(); i++)
+	{
+		const auto &v = vars[i];
+		const auto &info = cpool.globalVarList[i];
+
+		LETHE_RET_FALSE(v.offset == info.offset && v.size == info.type->size && v.data.GetSize() == v.size);
+		LETHE_RET_FALSE(v.typeName == info.type->GetName());
+	}
+
+	for (auto &&it : objects)
+	{
+		const auto *cls = prog.FindClass(Name(it.className));
+		LETHE_RET_FALSE(cls && cls->size == it.data.GetSize() && !(cls->structQualifiers & AST_Q_NATIVE));
+	}
+
+	return true;
+}
+
+bool GlobalSnapshot::Restore(CompiledProgram &prog) const
+{
+	LETHE_RET_FALSE(Validate(prog));
+
+	auto &cpool = prog.cpool;
+	auto *gdata = cpool.GetGlobalData();
+
+	// allocate objects and arrays first so that slots can point to them
+	Array<BaseObject *> objPtrs;
+	objPtrs.Reserve(objects.GetSize());
+
+	for (auto &&it : objects)
+	{
+		const auto *cls = prog.FindClass(Name(it.className));
+
+		// same as script new
+		auto *ptr = ObjectHeap::Get().Alloc(cls->size, cls->align, cls->classNameGroupKey);
+		MemCpy(ptr, it.data.GetData(), cls->size);
+		auto *obj = ::new(ptr) BaseObject;
+		obj->scriptVtbl = reinterpret_cast<void **>(gdata + cls->vtblOffset);
+		objPtrs.Add(obj);
+	}
+
+	Array<Byte *> arrPtrs;
+	arrPtrs.Reserve(arrays.GetSize());
+
+	for (auto &&it : arrays)
+	{
+		auto *ptr = static_cast<Byte *>(AlignedAlloc::Alloc(it.data.GetSize(), it.align));
+		MemCpy(ptr, it.data.GetData(), it.data.GetSize());
+		arrPtrs.Add(ptr);
+	}
+
+	auto applySlots = [&](Byte *dst, const Blob &b)
+	{
+		for (auto &&slot : b.slots)
+		{
+			auto *sdst = dst + slot.offset;
+
+			switch(slot.kind)
+			{
+			case SLOT_STRING:
+				*reinterpret_cast<String *>(sdst) = slot.text;
+				break;
+
+			case SLOT_NAME:
+				*reinterpret_cast<Name *>(sdst) = Name(slot.text);
+				break;
+
+			case SLOT_ARRAY:
+			{
+				auto &arr = *reinterpret_cast<SnapshotDynArray *>(sdst);
+				arr.data = arrPtrs[slot.index];
+				arr.size = arr.reserve = arrays[slot.index].count;
+			}
+			break;
+
+			default:
+			{
+				auto *obj = objPtrs[slot.index];
+				*reinterpret_cast<BaseObject **>(sdst) = obj;
+
+				if (slot.kind == SLOT_STRONG)
+					obj->AddRef();
+				else if (slot.kind == SLOT_WEAK)
+					RefAtomic::Increment(obj->weakRefCount);
+			}
+			}
+		}
+	};
+
+	for (auto &&v : vars)
+	{
+		auto *dst = gdata + v.offset;
+
+		// release baked strings before overwriting
+		for (auto &&slot : v.slots)
+			if (slot.kind == SLOT_STRING)
+				reinterpret_cast<String *>(dst + slot.offset)->Reset();
+
+		MemCpy(dst, v.data.GetData(), v.size);
+		applySlots(dst, v);
+	}
+
+	for (Int i=0; i<objects.GetSize(); i++)
+		applySlots(reinterpret_cast<Byte *>(objPtrs[i]), objects[i]);
+
+	for (Int i=0; i<arrays.GetSize(); i++)
+		applySlots(arrPtrs[i], arrays[i]);
+
+	// global dtors now own baked strings, same as after running global ctors
+	cpool.ClearGlobalBakedStrings();
+	return true;
+}
+
+bool GlobalSnapshot::SaveBlob(Stream &s, const Blob &b)
+{
+	LETHE_RET_FALSE(SnapshotWriteInt(s, b.data.GetSize()));
+	LETHE_RET_FALSE(b.data.IsEmpty() || s.Write(b.data.GetData(), b.data.GetSize()));
+	LETHE_RET_FALSE(SnapshotWriteInt(s, b.slots.GetSize()));
+
+	for (auto &&slot : b.slots)
+	{
+		LETHE_RET_FALSE(SnapshotWriteInt(s, slot.offset) && SnapshotWriteInt(s, slot.kind));
+
+		if (slot.kind == SLOT_STRING || slot.kind == SLOT_NAME)
+			LETHE_RET_FALSE(slot.text.Save(s));
+		else
+			LETHE_RET_FALSE(SnapshotWriteInt(s, slot.index));
+	}
+
+	return true;
+}
+
+bool GlobalSnapshot::LoadBlob(Stream &s, Blob &b, Int size)
+{
+	Int dsize, nslots;
+	LETHE_RET_FALSE(SnapshotReadInt(s, dsize) && dsize >= 0 && (size < 0 || dsize == size));
+	b.data.Resize(dsize);
+	LETHE_RET_FALSE(!dsize || s.Read(b.data.GetData(), dsize));
+	LETHE_RET_FALSE(SnapshotReadInt(s, nslots) && nslots >= 0);
+
+	b.slots.Resize(nslots);
+
+	for (auto &&slot : b.slots)
+	{
+		LETHE_RET_FALSE(SnapshotReadInt(s, slot.offset) && SnapshotReadInt(s, slot.kind));
+		LETHE_RET_FALSE(slot.kind >= 0 && slot.kind < SLOT_MAX);
+		LETHE_RET_FALSE(slot.offset >= 0 && slot.offset + GetSlotSize(slot.kind) <= dsize);
+
+		if (slot.kind == SLOT_STRING || slot.kind == SLOT_NAME)
+			LETHE_RET_FALSE(slot.text.Load(s));
+		else
+			LETHE_RET_FALSE(SnapshotReadInt(s, slot.index));
+	}
+
+	return true;
+}
+
+bool GlobalSnapshot::Save(Stream &s) const
+{
+	UInt magic = GLOBAL_SNAPSHOT_MAGIC;
+	Endian::ToLittle(magic);
+	LETHE_RET_FALSE(s.Write(&magic, sizeof(magic)));
+	LETHE_RET_FALSE(SnapshotWriteInt(s, GLOBAL_SNAPSHOT_VERSION));
+	LETHE_RET_FALSE(SnapshotWriteInt(s, (Int)sizeof(void *)));
+	LETHE_RET_FALSE(SnapshotWriteInt(s, dataSize));
+	LETHE_RET_FALSE(SnapshotWriteInt(s, vars.GetSize()));
+
+	for (auto &&v : vars)
+	{
+		LETHE_RET_FALSE(SnapshotWriteInt(s, v.offset));
+		LETHE_RET_FALSE(v.typeName.Save(s));
+		LETHE_RET_FALSE(SaveBlob(s, v));
+	}
+
+	LETHE_RET_FALSE(SnapshotWriteInt(s, objects.GetSize()));
+
+	for (auto &&o : objects)
+	{
+		LETHE_RET_FALSE(o.className.Save(s));
+		LETHE_RET_FALSE(SaveBlob(s, o));
+	}
+
+	LETHE_RET_FALSE(SnapshotWriteInt(s, arrays.GetSize()));
+
+	for (auto &&a : arrays)
+	{
+		LETHE_RET_FALSE(SnapshotWriteInt(s, a.count) && SnapshotWriteInt(s, a.align));
+		LETHE_RET_FALSE(SaveBlob(s, a));
+	}
+
+	return true;
+}
+
+bool GlobalSnapshot::Load(Stream &s)
+{
+	Clear();
+
+	UInt magic = 0;
+	LETHE_RET_FALSE(s.Read(&magic, sizeof(magic)));
+	Endian::FromLittle(magic);
+	LETHE_RET_FALSE(magic == GLOBAL_SNAPSHOT_MAGIC);
+
+	Int version, ptrSize, count;
+	LETHE_RET_FALSE(SnapshotReadInt(s, version) && version == GLOBAL_SNAPSHOT_VERSION);
+	LETHE_RET_FALSE(SnapshotReadInt(s, ptrSize) && ptrSize == (Int)sizeof(void *));
+	LETHE_RET_FALSE(SnapshotReadInt(s, dataSize) && dataSize >= 0);
+	LETHE_RET_FALSE(SnapshotReadInt(s, count) && count >= 0);
+
+	vars.Resize(count);
+
+	for (auto &&v : vars)
+	{
+		LETHE_RET_FALSE(SnapshotReadInt(s, v.offset) && v.offset >= 0);
+		LETHE_RET_FALSE(v.typeName.Load(s));
+		LETHE_RET_FALSE(LoadBlob(s, v, -1));
+		v.size = v.data.GetSize();
+		LETHE_RET_FALSE(v.offset + v.size <= dataSize);
+	}
+
+	LETHE_RET_FALSE(SnapshotReadInt(s, count) && count >= 0);
+	objects.Resize(count);
+
+	for (auto &&o : objects)
+	{
+		LETHE_RET_FALSE(o.className.Load(s));
+		LETHE_RET_FALSE(LoadBlob(s, o, -1));
+		LETHE_RET_FALSE(o.data.GetSize() >= (Int)sizeof(BaseObject));
+	}
+
+	LETHE_RET_FALSE(SnapshotReadInt(s, count) && count >= 0);
+	arrays.Resize(count);
+
+	for (auto &&a : arrays)
+	{
+		LETHE_RET_FALSE(SnapshotReadInt(s, a.count) && SnapshotReadInt(s, a.align));
+		LETHE_RET_FALSE(a.count > 0 && a.align >= 0);
+		LETHE_RET_FALSE(LoadBlob(s, a, -1));
+	}
+
+	// validate indices now so that Restore can trust them
+	auto validIndices = [&](const Blob &b)->bool
+	{
+		for (auto &&slot : b.slots)
+		{
+			if (slot.kind == SLOT_ARRAY)
+				LETHE_RET_FALSE(slot.index >= 0 && slot.index < arrays.GetSize());
+			else if (slot.kind != SLOT_STRING && slot.kind != SLOT_NAME)
+				LETHE_RET_FALSE(slot.index >= 0 && slot.index < objects.GetSize());
+		}
+
+		return true;
+	};
+
+	for (auto &&v : vars)
+		LETHE_RET_FALSE(validIndices(v));
+
+	for (auto &&o : objects)
+		LETHE_RET_FALSE(validIndices(o));
+
+	for (auto &&a : arrays)
+		LETHE_RET_FALSE(validIndices(a));
+
+	return true;
+}
+
+}
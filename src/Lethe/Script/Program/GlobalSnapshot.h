@@ -0,0 +1,109 @@
+#pragma once
+
+#include "../Common.h"
+
+#include <Lethe/Core/Sys/Types.h>
+#include <Lethe/Core/String/String.h>
+#include <Lethe/Core/Collect/Array.h>
+#include <Lethe/Core/Io/StreamDecl.h>
+
+namespace lethe
+{
+
+class CompiledProgram;
+class DataType;
+
+LETHE_API_BEGIN
+
+// snapshot of initialized global variables and script objects reachable from them, taken after running global constructors
+// plain data, strings, names, dynamic arrays and pointers to script objects are supported; objects are stored
+// as class name and field data, pointers are remapped by object index
+// non-empty delegates/function pointers/array refs, SoA arrays and native classes make capture fail
+// note: snapshot is only valid for the same program and platform
+class LETHE_API GlobalSnapshot
+{
+public:
+	GlobalSnapshot();
+
+	void Clear();
+	bool IsEmpty() const {return vars.IsEmpty();}
+
+	// capture global state; returns false if a global can't be snapshotted
+	bool Capture(const CompiledProgram &prog);
+	// restore global state into a freshly linked program (instead of running global constructors)
+	// returns false without touching global data if program layout doesn't match
+	bool Restore(CompiledProgram &prog) const;
+
+	// load/save from binary stream
+	bool Load(Stream &s);
+	bool Save(Stream &s) const;
+
+	enum SlotKind
+	{
+		SLOT_STRING,
+		SLOT_NAME,
+		// pointers, index = object index
+		SLOT_STRONG,
+		SLOT_WEAK,
+		SLOT_RAW,
+		// dynamic array, index = array index
+		SLOT_ARRAY,
+		SLOT_MAX
+	};
+
+	struct Slot
+	{
+		// offset relative to variable/object/array data
+		Int offset = 0;
+		Int kind = SLOT_STRING;
+		String text;
+		Int index = -1;
+	};
+
+	// raw data with slots zeroed
+	struct Blob
+	{
+		Array<Byte> data;
+		Array<Slot> slots;
+	};
+
+	struct Var : Blob
+	{
+		Int offset = 0;
+		Int size = 0;
+		String typeName;
+	};
+
+	// script object, object header is zeroed
+	struct Object : Blob
+	{
+		String className;
+	};
+
+	// dynamic array buffer
+	struct DynArray : Blob
+	{
+		Int count = 0;
+		Int align = 0;
+	};
+
+private:
+	struct CaptureState;
+
+	Int dataSize;
+	Array<Var> vars;
+	Array<Object> objects;
+	Array<DynArray> arrays;
+
+	bool CollectSlots(CaptureState &cs, const DataType &dt, const Byte *ptr, Int ofs, Array<Slot> &slots);
+	bool AddObject(CaptureState &cs, const void *ptr, Int &index);
+	static bool IsZero(const Byte *ptr, Int size);
+	static Int GetSlotSize(Int kind);
+	static bool SaveBlob(Stream &s, const Blob &b);
+	static bool LoadBlob(Stream &s, Blob &b, Int size);
+	bool Validate(const CompiledProgram &prog) const;
+};
+
+LETHE_API_END
+
+}
@@ -0,0 +1,184 @@
+#include "HeapProfiler.h"
+
+#include <Lethe/Core/Time/Timer.h>
+#include <Lethe/Core/Math/Templates.h>
+#include <Lethe/Script/TypeInfo/DataTypes.h>
+
+namespace lethe
+{
+
+// HeapProfiler
+
+HeapProfiler::HeapProfiler()
+	: startTicks(0)
+{
+}
+
+Int HeapProfiler::AddSite(const String &function, const String &file, Int line)
+{
+	MutexLock _(mutex);
+
+	auto key = String::Printf("%s:%d:%s", file.Ansi(), line, function.Ansi());
+	auto it = siteMap.Find(key);
+
+	if (it != siteMap.End())
+		return it->value;
+
+	Site s;
+	s.function = function;
+	s.file = file;
+	s.line = line;
+
+	auto res = sites.Add(s);
+	siteMap[key] = res;
+	return res;
+}
+
+void HeapProfiler::AddAlloc(Stats &st, Int size)
+{
+	++st.allocs;
+	++st.live;
+	st.totalBytes += (ULong)size;
+	st.liveBytes += size;
+	st.peakBytes = Max(st.peakBytes, st.liveBytes);
+}
+
+void HeapProfiler::AddFree(Stats &st, Int size)
+{
+	++st.frees;
+	--st.live;
+	st.liveBytes -= size;
+}
+
+void HeapProfiler::OnAlloc(const void *obj, const DataType *type, Int size, Int site)
+{
+	if (!obj || !type)
+		return;
+
+	MutexLock _(mutex);
+
+	if (!startTicks)
+		startTicks = Timer::GetHiCounter();
+
+	ObjectInfo oi;
+	oi.type = type;
+	oi.size = size;
+	oi.site = site >= 0 && site < sites.GetSize() ? site : -1;
+	objects[obj] = oi;
+
+	AddAlloc(classes[type], size);
+
+	if (oi.site >= 0)
+		AddAlloc(sites[oi.site].stats, size);
+}
+
+void HeapProfiler::OnFree(const void *obj)
+{
+	MutexLock _(mutex);
+
+	auto it = objects.Find(obj);
+
+	if (it == objects.End())
+		return;
+
+	const auto oi = it->value;
+	objects.Erase(it);
+
+	AddFree(classes[oi.type], oi.size);
+
+	if (oi.site >= 0)
+		AddFree(sites[oi.site].stats, oi.size);
+}
+
+void HeapProfiler::Reset()
+{
+	MutexLock _(mutex);
+
+	startTicks = 0;
+
+	auto resetStats = [](Stats &st)
+	{
+		st.allocs = st.frees = st.totalBytes = 0;
+		st.peakBytes = st.liveBytes;
+	};
+
+	for (auto &it : classes)
+		resetStats(it.value);
+
+	for (auto &it : sites)
+		resetStats(it.stats);
+}
+
+String HeapProfiler::FormatStats(const Stats &st, Double seconds)
+{
+	return String::Printf("live " LETHE_FORMAT_LONG " (" LETHE_FORMAT_LONG " bytes, peak " LETHE_FORMAT_LONG "), allocs "
+		LETHE_FORMAT_ULONG " (%0.1lf/sec, " LETHE_FORMAT_ULONG " bytes), frees " LETHE_FORMAT_ULONG,
+		st.live, st.liveBytes, st.peakBytes, st.allocs, seconds > 0 ? (Double)st.allocs / seconds : 0.0,
+		st.totalBytes, st.frees);
+}
+
+void HeapProfiler::Report(Array<String> &lines, Int maxEntries) const
+{
+	lines.Clear();
+
+	MutexLock _(mutex);
+
+	Double seconds = 0;
+
+	if (startTicks)
+		seconds = (Double)(Timer::GetHiCounter() - startTicks) / (Double)Timer::GetHiCounterFreq();
+
+	auto byLiveBytes = [](const Stats &a, const Stats &b)->bool
+	{
+		return a.liveBytes != b.liveBytes ? a.liveBytes > b.liveBytes : a.allocs > b.allocs;
+	};
+
+	Stats total;
+	Array<KeyValue<const DataType *, Stats>> clist;
+
+	for (const auto &it : classes)
+	{
+		total.allocs += it.value.allocs;
+		total.frees += it.value.frees;
+		total.totalBytes += it.value.totalBytes;
+		total.live += it.value.live;
+		total.liveBytes += it.value.liveBytes;
+		clist.Add(KeyValue<const DataType *, Stats>(it.key, it.value));
+	}
+
+	clist.Sort([&](const KeyValue<const DataType *, Stats> &a, const KeyValue<const DataType *, Stats> &b)->bool
+	{
+		return byLiveBytes(a.value, b.value);
+	});
+
+	lines.Add(String::Printf("heap profile (%0.6lf sec, " LETHE_FORMAT_ULONG " allocs, " LETHE_FORMAT_LONG " live objects, "
+		LETHE_FORMAT_LONG " live bytes)", seconds, total.allocs, total.live, total.liveBytes));
+	lines.Add("-------------------------------------------------------------------------------");
+
+	for (Int i=0; i<clist.GetSize() && i<maxEntries; i++)
+		lines.Add(String::Printf("class %s: ", clist[i].key->name.Ansi()) + FormatStats(clist[i].value, seconds));
+
+	Array<const Site *> slist;
+
+	for (const auto &it : sites)
+		if (it.stats.allocs || it.stats.live)
+			slist.Add(&it);
+
+	if (slist.IsEmpty())
+		return;
+
+	slist.Sort([&](const Site *a, const Site *b)->bool
+	{
+		return byLiveBytes(a->stats, b->stats);
+	});
+
+	lines.Add("allocation sites:");
+
+	for (Int i=0; i<slist.GetSize() && i<maxEntries; i++)
+	{
+		const auto &s = *slist[i];
+		lines.Add(String::Printf("    %s (%s:%d): ", s.function.Ansi(), s.file.Ansi(), s.line) + FormatStats(s.stats, seconds));
+	}
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../Common.h"
+
+#include <Lethe/Core/Sys/Types.h>
+#include <Lethe/Core/Sys/NoCopy.h>
+#include <Lethe/Core/String/String.h>
+#include <Lethe/Core/Collect/Array.h>
+#include <Lethe/Core/Collect/HashMap.h>
+#include <Lethe/Core/Thread/Lock.h>
+
+namespace lethe
+{
+
+class DataType;
+
+LETHE_API_BEGIN
+
+// per-class and per-callsite statistics for script objects created via new
+// enabled via ScriptEngine::EnableHeapProfiling; allocation sites are registered during codegen,
+// objects are tracked from construction until the base object dtor runs
+// stack objects and objects constructed in place are not tracked; host NewObject uses a (host) site
+class LETHE_API HeapProfiler : NoCopy
+{
+public:
+	HeapProfiler();
+
+	struct Stats
+	{
+		ULong allocs = 0;
+		ULong frees = 0;
+		// total bytes allocated so far
+		ULong totalBytes = 0;
+		Long live = 0;
+		Long liveBytes = 0;
+		Long peakBytes = 0;
+	};
+
+	struct Site
+	{
+		// function being generated
+		String function;
+		String file;
+		Int line = 0;
+		Stats stats;
+	};
+
+	// called during codegen, returns site index
+	// same location in same function maps to the same site (unrolled loops)
+	Int AddSite(const String &function, const String &file, Int line);
+
+	// size is actual block size (including size class rounding)
+	void OnAlloc(const void *obj, const DataType *type, Int size, Int site);
+	// unknown objects are ignored
+	void OnFree(const void *obj);
+
+	// reset counters and rates; live objects stay tracked
+	void Reset();
+
+	// format report, at most maxEntries classes and sites sorted by live bytes
+	void Report(Array<String> &lines, Int maxEntries) const;
+
+private:
+	struct ObjectInfo
+	{
+		const DataType *type;
+		Int size;
+		Int site;
+	};
+
+	static void AddAlloc(Stats &st, Int size);
+	static void AddFree(Stats &st, Int size);
+	static String FormatStats(const Stats &st, Double seconds);
+
+	mutable Mutex mutex;
+	Array<Site> sites;
+	HashMap<String, Int> siteMap;
+	HashMap<const DataType *, Stats> classes;
+	HashMap<const void *, ObjectInfo> objects;
+	// time of first allocation after reset, 0 = none yet
+	ULong startTicks;
+};
+
+LETHE_API_END
+
+}
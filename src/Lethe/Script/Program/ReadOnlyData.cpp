@@ -0,0 +1,89 @@
+#include "ReadOnlyData.h"
+
+#include <Lethe/Core/Collect/Array.h>
+#include <Lethe/Core/Hash/HashBuffer.h>
+#include <Lethe/Core/Memory/Heap.h>
+#include <Lethe/Core/Memory/Memory.h>
+#include <Lethe/Core/Thread/Lock.h>
+
+namespace lethe
+{
+
+struct ReadOnlyDataRegistry
+{
+	SpinMutex mutex;
+	Array<ReadOnlyData *> blocks;
+};
+
+static ReadOnlyDataRegistry &ReadOnlyData_GetRegistry()
+{
+	static ReadOnlyDataRegistry registry;
+	return registry;
+}
+
+// ReadOnlyData
+
+const ReadOnlyData *ReadOnlyData::Acquire(const Byte *src, Int size)
+{
+	LETHE_ASSERT(src && size > 0);
+
+	auto hash = HashBuffer(src, (size_t)size);
+
+	auto &reg = ReadOnlyData_GetRegistry();
+	SpinMutexLock _(reg.mutex);
+
+	for (auto *it : reg.blocks)
+	{
+		if (it->hash == hash && it->size == size && MemCmp(it->data, src, (size_t)size) == 0)
+		{
+			it->refCount++;
+			return it;
+		}
+	}
+
+	size_t pageSize = (size_t)size;
+	auto *data = static_cast<Byte *>(Heap::AllocatePages(pageSize));
+
+	if (!data)
+		return nullptr;
+
+	MemCpy(data, src, (size_t)size);
+
+	// not fatal, data stays writable
+	Heap::WriteProtectPages(data, pageSize, true);
+
+	auto *res = new ReadOnlyData;
+	res->data = data;
+	res->size = size;
+	res->pageSize = pageSize;
+	res->hash = hash;
+	res->refCount = 1;
+	reg.blocks.Add(res);
+
+	return res;
+}
+
+void ReadOnlyData::Release(const ReadOnlyData *rod)
+{
+	if (!rod)
+		return;
+
+	auto &reg = ReadOnlyData_GetRegistry();
+	SpinMutexLock _(reg.mutex);
+
+	auto *tmp = const_cast<ReadOnlyData *>(rod);
+
+	LETHE_ASSERT(tmp->refCount > 0);
+
+	if (--tmp->refCount)
+		return;
+
+	Int idx = reg.blocks.FindIndex(tmp);
+	LETHE_ASSERT(idx >= 0);
+	reg.blocks.EraseFast(idx);
+
+	Heap::FreePages(tmp->data, tmp->pageSize);
+	delete tmp;
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../Common.h"
+
+#include <Lethe/Core/Sys/Types.h>
+#include <Lethe/Core/Sys/NoCopy.h>
+
+namespace lethe
+{
+
+LETHE_API_BEGIN
+
+// constant global data in write-protected pages
+// blocks with identical contents are shared between programs, so engines compiling the same scripts
+// only keep one copy
+class LETHE_API ReadOnlyData : NoCopy
+{
+public:
+	inline const Byte *GetData() const {return data;}
+	inline Int GetSize() const {return size;}
+	// page-rounded size
+	inline size_t GetMemUsage() const {return pageSize;}
+
+	// find shared block with same contents or create a new one
+	// returns null on failure
+	static const ReadOnlyData *Acquire(const Byte *src, Int size);
+	// release block acquired before
+	static void Release(const ReadOnlyData *rod);
+
+private:
+	ReadOnlyData() = default;
+	~ReadOnlyData() = default;
+
+	Byte *data = nullptr;
+	Int size = 0;
+	size_t pageSize = 0;
+	UInt hash = 0;
+	// protected by registry lock
+	Int refCount = 0;
+};
+
+LETHE_API_END
+
+}
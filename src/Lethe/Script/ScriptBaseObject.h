@@ -10,6 +10,9 @@ namespace lethe
 
 class DataType;
 
+// build with LETHE_SINGLE_THREADED_REFS for non-atomic reference counting (including JIT code)
+// if script objects never cross threads
+
 #ifdef LETHE_CUSTOM_BASE_OBJECT
 
 using ScriptBaseObject = LETHE_CUSTOM_BASE_OBJECT;
@@ -70,7 +73,7 @@ public:
 	// reference counting support
 	UInt AddRef() const
 	{
-		auto res = Atomic::Increment(strongRefCount);
+		auto res = RefAtomic::Increment(strongRefCount);
 		LETHE_ASSERT(res);
 		return res;
 	}
@@ -81,7 +84,10 @@ public:
 
 		if (!res)
 		{
-			DestroyScriptObject();
+			// only the header of a dead object is accessed through weak refs
+			if (DestroyScriptObject() && RefAtomic::Load(weakRefCount) > 1)
+				ObjectHeap::Get().Trim((void *)this, sizeof(*this));
+
 			ReleaseWeak();
 		}
 
@@ -91,7 +97,7 @@ public:
 	// careful with this one
 	UInt DecRefCount() const
 	{
-		auto res = Atomic::Decrement(strongRefCount);
+		auto res = RefAtomic::Decrement(strongRefCount);
 		LETHE_ASSERT(res != 0xffffffffu);
 		return res;
 	}
@@ -100,14 +106,14 @@ public:
 	{
 		LETHE_ASSERT(strongRefCount != 0);
 		LETHE_ASSERT(weakRefCount != 0);
-		auto res = Atomic::Increment(weakRefCount);
+		auto res = RefAtomic::Increment(weakRefCount);
 		LETHE_ASSERT(res);
 		return res;
 	}
 
 	UInt ReleaseWeak() const
 	{
-		auto res = Atomic::Decrement(weakRefCount);
+		auto res = RefAtomic::Decrement(weakRefCount);
 		LETHE_ASSERT(res != 0xffffffffu);
 
 		if (!res)
@@ -122,7 +128,7 @@ public:
 	// careful here as well
 	bool HasStrongRef() const
 	{
-		return Atomic::Load(strongRefCount) != 0;
+		return RefAtomic::Load(strongRefCount) != 0;
 	}
 };
 
@@ -2,18 +2,63 @@
 #include "ScriptEngine.h"
 #include "Utils/NativeHelpers.h"
 #include <Lethe/Core/Thread/Thread.h>
+#include <Lethe/Core/Thread/Fiber.h>
 
 #include <Lethe/Core/String/StringBuilder.h>
 
 #include "Program/CompiledProgram.h"
 #include "Program/ConstPool.h"
+#include "Program/HeapProfiler.h"
 
 namespace lethe
 {
 
+// ScriptContext::Coroutine
+
+struct ScriptContext::Coroutine
+{
+	ScriptContext *context = nullptr;
+	ScriptDelegate dg;
+	// swapped with context stack while running
+	UniquePtr<Stack> stack;
+	UniquePtr<Fiber> fiber;
+	// arena scope depth when resumed, scopes opened inside must be closed before yielding
+	Int arenaBase = 0;
+	bool started = false;
+	// cancelled: yields fail so that coroutine can return and destroy its locals
+	bool cancel = false;
+	Int cancelYields = 0;
+
+	void Run()
+	{
+		context->CallDelegate(dg);
+	}
+};
+
 // ScriptContext
 
-ScriptContext::ScriptContext(Int stkSize)
+// default debug break, assuming context is bound to a thread,
+// waits for break mode flag to be reset from the outside, ready to process next instruction
+static bool ScriptContext_DefaultDebugBreak(ScriptContext &ctx, ExecResult &)
+{
+	auto tmp = ctx.GetCallStack();
+
+	auto &eng = ctx.GetEngine();
+
+	eng.onInfo(String::Printf("debug break in context 0x" LETHE_FORMAT_UINTPTR_HEX, (UIntPtr)(void *)&ctx));
+
+	for (auto &&it : tmp)
+		eng.onInfo(it.Ansi());
+
+	while (ctx.InBreakMode())
+		Thread::Sleep(10);
+
+	// continue execution
+	return false;
+}
+
+
+ScriptContext::ScriptContext(Int stkSize, Int maxStkSize)
 	: vmJit(nullptr)
 	, mode(ENGINE_JIT)
 	, mutex(Mutex::Recursive())
@@ -22,35 +67,41 @@ ScriptContext::ScriptContext(Int stkSize)
 	if (stkSize <= 0)
 		stkSize = 65536;
 
-	vmStack = new Stack(stkSize);
+	vmStack = new Stack(stkSize, maxStkSize);
 	vmStack->context = this;
 	vm = new Vm;
 	vm->SetStack(vmStack);
 	vm->onRuntimeError.Set(this, &Self::OnRuntimeError);
 	vm->onDebugBreak.Set(this, &Self::OnDebugBreak);
 
-	// default debug break, assuming context is bound to a thread,
-	// waits for break mode flag to be reset from the outside, ready to process next instruction
-	onDebugBreak = [](ScriptContext &ctx, ExecResult &)->bool
-	{
-		auto tmp = ctx.GetCallStack();
+	onDebugBreak = ScriptContext_DefaultDebugBreak;
+}
+
+ScriptContext::~ScriptContext()
+{
+	CancelCoroutines();
 
-		auto &eng = ctx.GetEngine();
+	for (auto *it : freeCoroutines)
+		delete it;
 
-		eng.onInfo(String::Printf("debug break in context 0x" LETHE_FORMAT_UINTPTR_HEX, (UIntPtr)(void *)&ctx));
+	while (!arenas.IsEmpty())
+		EndArena();
 
-		for (auto &&it : tmp)
-			eng.onInfo(it.Ansi());
+	ProcessDeferredReleases();
 
-		while (ctx.InBreakMode())
-			Thread::Sleep(10);
+	// objects that escaped still live in arena memory, so their arenas are leaked rather than freed
+	ReclaimRetiredArenas();
 
-		// continue execution
-		return false;
-	};
+	for (auto &&it : retiredArenas)
+		it.arena->AddRef();
+
+	ReportProfiling();
+
+	MutexLock lock(engine->contextMutex);
+	engine->contexts.Erase(engine->contexts.FindIndex(this));
 }
 
-ScriptContext::~ScriptContext()
+void ScriptContext::ReportProfiling() const
 {
 	auto frq = Timer::GetHiCounterFreq();
 
@@ -85,14 +136,54 @@ ScriptContext::~ScriptContext()
 		for (auto &&cf : i.calledFrom)
 			engine->onInfo(String::Printf("    called from: %s", vmStack->GetConstantPool().sPool[profiling.GetKey(cf).key].Ansi()));
 	}
-
-	MutexLock lock(engine->contextMutex);
-	engine->contexts.Erase(engine->contexts.FindIndex(this));
 }
 
 SharedPtr<ScriptContext> ScriptContext::Clone() const
 {
-	return engine->CreateContext();
+	return engine->AcquireContext(vmStack->GetCommittedSize(), vmStack->GetMaxSize());
+}
+
+bool ScriptContext::Reset()
+{
+	LETHE_RET_FALSE(!vmStack->nesting && !activeCoroutine);
+
+	CancelCoroutines();
+
+	while (!arenas.IsEmpty())
+		EndArena();
+
+	ProcessDeferredReleases();
+	deferRelease = false;
+
+	ReclaimRetiredArenas();
+
+	ReportProfiling();
+	profiling.Clear();
+	profStack.Clear();
+	profParent = -1;
+
+	debugData.stepCmd = 0;
+	debugData.activeStepCmd = 0;
+	debugData.activeCallStackDepth = 0;
+	debugData.origLoc = TokenLocation();
+	debugData.origFunction.Clear();
+
+	stateDelegateRef = nullptr;
+	debugName.Clear();
+
+	// callbacks set by the previous user may point to objects that no longer exist
+	onRuntimeError.Clear();
+	onDebugBreak = ScriptContext_DefaultDebugBreak;
+
+	auto &stk = *vmStack;
+	stk.top = stk.bottom;
+	stk.thisPtr = nullptr;
+	stk.growRequest = 0;
+	stk.insPtr = nullptr;
+	stk.programCounter = -1;
+	stk.breakExecution = 0;
+
+	return true;
 }
 
 String ScriptContext::GetName() const
@@ -131,10 +222,10 @@ Array<String> ScriptContext::GetGlobals(Int maxVarTextLen) const
 		sb += it.key;
 		sb += " = ";
 
-		auto *gdata = prog->cpool.data.GetData();
-
 		const auto &ginfo = it.value;
 
+		auto *gdata = ginfo.readOnly ? prog->cpool.GetReadOnlyData() : prog->cpool.data.GetData();
+
 		const void *ptr = gdata + ginfo.offset;
 
 		if (ginfo.qualifiers & AST_Q_REFERENCE)
@@ -170,17 +261,32 @@ ExecResult ScriptContext::RunConstructors()
 
 ExecResult ScriptContext::RunDestructors()
 {
+	ExecResult res = EXEC_OK;
+
 	if (vmJit)
 	{
 		Int idx = vm->prog->globalDestIndex;
 
-		if (idx < 0)
-			return EXEC_OK;
-
-		return vmJit->ExecScriptFunc(*vm, idx);
+		if (idx >= 0)
+			res = vmJit->ExecScriptFunc(*vm, idx);
 	}
+	else
+		res = vm->CallGlobalDestructors();
+
+	// globals may have released objects
+	ProcessDeferredReleases();
 
-	return vm->CallGlobalDestructors();
+	return res;
+}
+
+bool ScriptContext::CaptureGlobals(GlobalSnapshot &snap) const
+{
+	return snap.Capture(*vm->prog);
+}
+
+bool ScriptContext::RestoreGlobals(const GlobalSnapshot &snap)
+{
+	return snap.Restore(*vm->prog);
 }
 
 ExecResult ScriptContext::Call(const StringRef &fname)
@@ -271,6 +377,13 @@ BaseObject *ScriptContext::NewObject(Name name)
 
 	stk.Pop(1);
 
+	if (auto *hp = stk.GetConstantPool().heapProfiler)
+	{
+		// objects created by the host share one pseudo-site
+		stk.PushInt((UInt)hp->AddSite("(host)", String(), 0));
+		Builtin::OpCode_HeapProfNew(stk);
+	}
+
 	// note: strong ref is 0
 	auto *res = static_cast<BaseObject *>(stk.GetPtr(0));
 	stk.Pop(1);
@@ -437,6 +550,495 @@ ExecResult ScriptContext::CallMethodByPointer(const void *ptr, const void *insta
 	return res;
 }
 
+void ScriptContext::EnableDeferredRelease(bool enable)
+{
+	if (!enable)
+		ProcessDeferredReleases();
+
+	deferRelease = enable;
+}
+
+Int ScriptContext::ProcessDeferredReleases(Int budgetUs, Int maxObjects)
+{
+	if (deferredReleases.IsEmpty())
+		return 0;
+
+	ULong start = Timer::GetHiCounter();
+	ULong budgetTicks = (ULong)budgetUs * Timer::GetHiCounterFreq() / 1000000u;
+
+	Int count = 0;
+
+	while (!deferredReleases.IsEmpty())
+	{
+		if (maxObjects > 0 && count >= maxObjects)
+			break;
+
+		// always make some progress
+		if (budgetUs > 0 && count > 0 && Timer::GetHiCounter() - start >= budgetTicks)
+			break;
+
+		// LIFO: objects released by the last destructor are likely still in cache
+		auto *obj = deferredReleases.Back();
+		deferredReleases.Pop();
+		DestroyDeferred(obj);
+		++count;
+	}
+
+	return deferredReleases.GetSize();
+}
+
+void ScriptContext::CallObjectDtor(BaseObject *obj)
+{
+	auto &stk = *vmStack;
+	auto *oldThis = stk.GetThis();
+	stk.SetThis(obj);
+	stk.PushPtr(obj);
+	CallPointer(obj->scriptVtbl[0]);
+	stk.Pop(1);
+	stk.SetThis(oldThis);
+}
+
+void ScriptContext::DestroyDeferred(BaseObject *obj)
+{
+	// same as script code: call dtor via vtbl, then drop implicit weak ref
+	CallObjectDtor(obj);
+
+	if (RefAtomic::Load(obj->weakRefCount) > 1)
+		ObjectHeap::Get().Trim(obj, sizeof(BaseObject));
+
+	if (!RefAtomic::Decrement(obj->weakRefCount))
+		ObjectHeap::Get().Dealloc(obj);
+}
+
+// calls fn for each non-null strong pointer stored in data of type dt
+// SoA arrays and reference members are skipped, their targets then look referenced from outside
+template<typename F>
+static void ScriptContext_ForEachStrongRef(const DataType &dt, const Byte *ptr, F &fn)
+{
+	switch(dt.type)
+	{
+	case DT_STRONG_PTR:
+		if (const auto *obj = *reinterpret_cast<const BaseObject * const *>(ptr))
+			fn(obj);
+
+		break;
+
+	case DT_STATIC_ARRAY:
+	{
+		const auto &etype = dt.elemType.GetType();
+		auto esize = dt.elemType.GetSize();
+
+		for (Int i=0; i<dt.arrayDims; i++)
+			ScriptContext_ForEachStrongRef(etype, ptr + (IntPtr)i*esize, fn);
+	}
+	break;
+
+	case DT_DYNAMIC_ARRAY:
+	{
+		const auto &etype = dt.elemType.GetType();
+
+		if (etype.IsSoa())
+			break;
+
+		const auto *aref = reinterpret_cast<const ArrayRef<Byte> *>(ptr);
+		const auto *data = aref->GetData();
+		auto esize = dt.elemType.GetSize();
+
+		for (Int i=0; i<aref->GetSize(); i++)
+			ScriptContext_ForEachStrongRef(etype, data + (IntPtr)i*esize, fn);
+	}
+	break;
+
+	case DT_STRUCT:
+	case DT_CLASS:
+		if (dt.baseType.GetTypeEnum() != DT_NONE)
+			ScriptContext_ForEachStrongRef(dt.baseType.GetType(), ptr, fn);
+
+		for (auto &&m : dt.members)
+		{
+			if (!m.type.IsReference() && m.type.HasDtor())
+				ScriptContext_ForEachStrongRef(m.type.GetType(), ptr + m.offset, fn);
+		}
+
+		break;
+
+	default:;
+	}
+}
+
+void ScriptContext::BeginArena()
+{
+	SharedPtr<ArenaAlloc> arena;
+
+	if (!freeArenas.IsEmpty())
+	{
+		arena = freeArenas.Back();
+		freeArenas.Pop();
+	}
+	else
+		arena = new ArenaAlloc;
+
+	arenas.Add(arena);
+	arenaStarts.Add(arenaObjects.GetSize());
+}
+
+Int ScriptContext::EndArena()
+{
+	if (arenas.IsEmpty())
+		return -1;
+
+	// queued objects may live in arena memory
+	ProcessDeferredReleases();
+
+	// close scope first, dtors allocate from outer scope (or heap)
+	auto arena = arenas.Back();
+	arenas.Pop();
+
+	auto start = arenaStarts.Back();
+	arenaStarts.Pop();
+
+	Array<BaseObject *> objs;
+	objs.Reserve(arenaObjects.GetSize() - start);
+
+	for (Int i=start; i<arenaObjects.GetSize(); i++)
+		objs.Add(arenaObjects[i]);
+
+	arenaObjects.Resize(start);
+
+	// objects still alive: cycles or objects referenced from outside
+	Array<BaseObject *> live;
+	HashMap<const BaseObject *, Int> liveIndex;
+
+	for (auto *it : objs)
+	{
+		if (!it->HasStrongRef())
+			continue;
+
+		liveIndex[it] = live.GetSize();
+		live.Add(it);
+	}
+
+	auto findLive = [&](const BaseObject *obj)->Int
+	{
+		auto idx = liveIndex.FindIndex(obj);
+		return idx < 0 ? -1 : liveIndex.GetValue(idx);
+	};
+
+	// count strong refs held by live objects themselves, the rest comes from outside (globals, locals, heap)
+	Array<UInt> inner(live.GetSize(), 0);
+	Array<const DataType *> types(live.GetSize(), nullptr);
+
+	auto countInner = [&](const BaseObject *obj)
+	{
+		auto idx = findLive(obj);
+
+		if (idx >= 0)
+			inner[idx]++;
+	};
+
+	for (Int i=0; i<live.GetSize(); i++)
+	{
+		// dtors switch vtbl to base class, keep dynamic type for report
+		types[i] = live[i]->GetScriptClassType();
+
+		if (types[i])
+			ScriptContext_ForEachStrongRef(*types[i], reinterpret_cast<const Byte *>(live[i]), countInner);
+	}
+
+	// objects referenced from outside and everything reachable from them escape; they're left untouched
+	// and destroyed normally when released
+	Array<bool> keep(live.GetSize(), false);
+	Array<Int> work;
+
+	for (Int i=0; i<live.GetSize(); i++)
+	{
+		if (RefAtomic::Load(live[i]->strongRefCount) <= inner[i])
+			continue;
+
+		keep[i] = true;
+		work.Add(i);
+	}
+
+	auto markKeep = [&](const BaseObject *obj)
+	{
+		auto idx = findLive(obj);
+
+		if (idx < 0 || keep[idx])
+			return;
+
+		keep[idx] = true;
+		work.Add(idx);
+	};
+
+	while (!work.IsEmpty())
+	{
+		auto idx = work.Back();
+		work.Pop();
+
+		if (types[idx])
+			ScriptContext_ForEachStrongRef(*types[idx], reinterpret_cast<const Byte *>(live[idx]), markKeep);
+	}
+
+	// pin unreachable objects so that their dtors can't destroy each other
+	Array<BaseObject *> dead;
+
+	for (Int i=0; i<live.GetSize(); i++)
+	{
+		if (keep[i])
+			continue;
+
+		live[i]->AddRef();
+		dead.Add(live[i]);
+	}
+
+	for (auto *it : dead)
+		CallObjectDtor(it);
+
+	// objects resurrected by dtors stay pinned so they are never destroyed again
+	for (auto *it : dead)
+	{
+		if (RefAtomic::Load(it->strongRefCount) > 1)
+			continue;
+
+		it->strongRefCount = 0;
+		RefAtomic::Decrement(it->weakRefCount);
+	}
+
+	// only the weak ref held by arena should remain
+	RetiredArena retired;
+	const DataType *first = nullptr;
+
+	for (auto *it : objs)
+	{
+		if (RefAtomic::Load(it->weakRefCount) <= 1)
+			continue;
+
+		if (retired.objects.IsEmpty())
+		{
+			auto idx = findLive(it);
+			first = idx >= 0 ? types[idx] : nullptr;
+		}
+
+		retired.objects.Add(it);
+	}
+
+	const Int escaped = retired.objects.GetSize();
+
+	if (escaped)
+	{
+		// weak ref held by arena is never dropped, so arena memory never reaches ObjectHeap
+		retired.arena = arena;
+		retiredArenas.Add(retired);
+
+		if (mode == ENGINE_DEBUG || mode == ENGINE_DEBUG_NOBREAK)
+		{
+			// not an error: escaped objects stay valid
+			engine->onInfo(String::Printf("%d object(s) escaped arena scope (first: %s), arena memory kept alive", escaped,
+				first ? first->name.Ansi() : "?"));
+		}
+
+		return escaped;
+	}
+
+	arena->Reset();
+
+	if (freeArenas.GetSize() < 4)
+		freeArenas.Add(arena);
+
+	ReclaimRetiredArenas();
+
+	return 0;
+}
+
+void ScriptContext::ReclaimRetiredArenas()
+{
+	for (Int i=retiredArenas.GetSize()-1; i>=0; i--)
+	{
+		auto &ra = retiredArenas[i];
+
+		bool gone = true;
+
+		// released (and not weakly referenced): only the weak ref held by arena remains
+		for (auto *it : ra.objects)
+		{
+			if (RefAtomic::Load(it->strongRefCount) || RefAtomic::Load(it->weakRefCount) > 1)
+			{
+				gone = false;
+				break;
+			}
+		}
+
+		if (!gone)
+			continue;
+
+		ra.arena->Reset();
+
+		if (freeArenas.GetSize() < 4)
+			freeArenas.Add(ra.arena);
+
+		retiredArenas.EraseIndexFast(i);
+	}
+}
+
+void ScriptContext::SetCoroutineStackSize(Int stkSize, Int nativeSize)
+{
+	coStackSize = stkSize;
+	coNativeStackSize = nativeSize;
+
+	// don't reuse old stacks
+	for (auto *it : freeCoroutines)
+		delete it;
+
+	freeCoroutines.Clear();
+}
+
+bool ScriptContext::StartCoroutine(const ScriptDelegate &dg)
+{
+	LETHE_RET_FALSE(!dg.IsEmpty());
+
+	Coroutine *co;
+
+	if (!freeCoroutines.IsEmpty())
+	{
+		co = freeCoroutines.Back();
+		freeCoroutines.Pop();
+		LETHE_VERIFY(co->fiber->Reset());
+	}
+	else
+	{
+		// script stack lives in fiber memory to keep number of OS mappings low
+		const size_t stkBytes = (size_t)(coStackSize + 4)*Stack::WORD_SIZE;
+
+		co = new Coroutine;
+		co->context = this;
+		co->fiber = new Fiber(Delegate<void()>(co, &Coroutine::Run), (size_t)coNativeStackSize, stkBytes);
+
+		if (!co->fiber->IsValid())
+		{
+			delete co;
+			return false;
+		}
+
+		co->stack = new Stack(co->fiber->GetUserMemory(), stkBytes);
+		co->stack->context = this;
+	}
+
+	co->dg = dg;
+	co->started = co->cancel = false;
+	co->cancelYields = 0;
+
+	if (!dg.IsStruct())
+		static_cast<const BaseObject *>(dg.instancePtr)->AddRef();
+
+	coroutines.Add(co);
+	return true;
+}
+
+Int ScriptContext::RunCoroutines()
+{
+	if (activeCoroutine)
+		return coroutines.GetSize();
+
+	// coroutines started meanwhile are appended
+	const Int count = coroutines.GetSize();
+
+	for (Int i=0; i<count; i++)
+		ResumeCoroutine(*coroutines[i]);
+
+	Array<Coroutine *> done;
+	Int dst = 0;
+
+	for (auto *it : coroutines)
+	{
+		if (it->fiber->IsDone())
+			done.Add(it);
+		else
+			coroutines[dst++] = it;
+	}
+
+	coroutines.Resize(dst);
+
+	for (auto *it : done)
+		FinishCoroutine(*it);
+
+	return coroutines.GetSize();
+}
+
+bool ScriptContext::YieldCoroutine()
+{
+	LETHE_RET_FALSE(activeCoroutine && Fiber::GetCurrent() == activeCoroutine->fiber.Get());
+	LETHE_RET_FALSE(arenas.GetSize() == activeCoroutine->arenaBase);
+
+	if (activeCoroutine->cancel)
+	{
+		// fail without suspending so that loops can exit; coroutines that keep yielding are abandoned
+		if (++activeCoroutine->cancelYields < MAX_CANCEL_YIELDS)
+			return false;
+
+		Fiber::Suspend();
+		return false;
+	}
+
+	return Fiber::Suspend();
+}
+
+void ScriptContext::CancelCoroutines()
+{
+	// coroutines started meanwhile are cancelled too
+	while (!coroutines.IsEmpty())
+	{
+		auto *co = coroutines.Back();
+		coroutines.Pop();
+
+		if (co->started && !co->fiber->IsDone())
+		{
+			co->cancel = true;
+			ResumeCoroutine(*co);
+
+			if (!co->fiber->IsDone() && (mode == ENGINE_DEBUG || mode == ENGINE_DEBUG_NOBREAK))
+				onRuntimeError("cancelled coroutine kept yielding, abandoned (locals not destroyed)");
+		}
+
+		FinishCoroutine(*co);
+	}
+}
+
+void ScriptContext::ResumeCoroutine(Coroutine &co)
+{
+	activeCoroutine = &co;
+	co.arenaBase = arenas.GetSize();
+	co.started = true;
+	vmStack.SwapWith(co.stack);
+	vm->SetStack(vmStack);
+
+	co.fiber->Resume();
+
+	vmStack.SwapWith(co.stack);
+	vm->SetStack(vmStack);
+	activeCoroutine = nullptr;
+}
+
+void ScriptContext::FinishCoroutine(Coroutine &co)
+{
+	auto dg = co.dg;
+	co.dg.Clear();
+
+	// may be unbalanced after runtime error
+	auto &stk = *co.stack;
+	stk.top = stk.bottom;
+	stk.thisPtr = nullptr;
+	stk.insPtr = nullptr;
+
+	if (co.fiber->IsDone() && freeCoroutines.GetSize() < 64)
+		freeCoroutines.Add(&co);
+	else
+		delete &co;
+
+	// note: release last as this may run script code
+	if (!dg.IsStruct())
+		static_cast<const BaseObject *>(dg.instancePtr)->Release();
+}
+
 void ScriptContext::OnRuntimeError(const char *msg)
 {
 	onRuntimeError(msg);
@@ -7,6 +7,7 @@
 #include <Lethe/Core/Ptr/SharedPtr.h>
 #include <Lethe/Core/Io/StreamDecl.h>
 #include <Lethe/Core/Ptr/RefCounted.h>
+#include <Lethe/Core/Memory/ArenaAlloc.h>
 #include <Lethe/Core/String/String.h>
 #include <Lethe/Core/Collect/HashSet.h>
 #include <Lethe/Core/Collect/HashMap.h>
@@ -19,6 +20,7 @@
 #include "Vm/Vm.h"
 
 #include "Program/ConstPool.h"
+#include "Program/GlobalSnapshot.h"
 
 #include "TypeInfo/DataTypes.h"
 
@@ -62,11 +64,17 @@ class LETHE_API ScriptContext : public NoCopy, public RefCounted
 	~ScriptContext();
 public:
 	// stack size in stack words; 0 = default
-	ScriptContext(Int stkSize = 0);
+	// maxStkSize > stkSize: stack reserves maxStkSize words and grows on demand (see Stack)
+	ScriptContext(Int stkSize = 0, Int maxStkSize = 0);
 
-	// clone context (creates new stack and Vm)
+	// clone context (new stack and Vm with the same stack size, reused from engine context pool if possible)
 	SharedPtr<ScriptContext> Clone() const;
 
+	// reset idle context for reuse: stack, break flags, profiling and debug state, deferred releases
+	// and coroutines (suspended ones are cancelled, see CancelCoroutines); delegates and stack memory are kept
+	// returns false if context is executing
+	bool Reset();
+
 	// get/set debug name
 	String GetName() const;
 	void SetName(const String &ctxname);
@@ -92,6 +100,12 @@ public:
 	ExecResult RunConstructors();
 	ExecResult RunDestructors();
 
+	// capture initialized globals and objects reachable from them after RunConstructors; returns false if not possible
+	bool CaptureGlobals(GlobalSnapshot &snap) const;
+	// restore globals from snapshot instead of calling RunConstructors
+	// program must be identical; returns false (globals untouched) on layout mismatch
+	bool RestoreGlobals(const GlobalSnapshot &snap);
+
 	// stack must be prepared (including thisPtr when calling a struct method)
 	ExecResult Call(const StringRef &fname);
 
@@ -124,6 +138,49 @@ public:
 	void ConstructObject(Name name, void *inst);
 	void DestructObject(Name name, void *inst);
 
+	// deferred release: objects whose strong refcount drops to zero in script code are queued
+	// instead of being destroyed right away; disabling destroys everything queued
+	void EnableDeferredRelease(bool enable);
+	inline bool IsDeferredReleaseEnabled() const {return deferRelease;}
+	// destroy queued objects until time budget (microseconds) or object budget runs out, 0 = unlimited
+	// objects released by their destructors are queued as well
+	// returns number of objects still queued
+	Int ProcessDeferredReleases(Int budgetUs = 0, Int maxObjects = 0);
+	inline Int GetDeferredReleaseCount() const {return deferredReleases.GetSize();}
+
+	// coroutines: script delegates running on their own script stack and native fiber;
+	// they can suspend anywhere (coroutine_yield in script) and are resumed by RunCoroutines
+	// both stacks share one reservation per coroutine, physical pages are only allocated when touched
+	// stack sizes for new coroutines: script stack in stack words, native stack in bytes
+	void SetCoroutineStackSize(Int stkSize, Int nativeSize);
+	// start new coroutine, first run happens in next RunCoroutines call
+	// holds a strong reference to delegate instance until done
+	bool StartCoroutine(const ScriptDelegate &dg);
+	// resume each coroutine once until it yields or returns; returns number of coroutines still alive
+	// coroutines started meanwhile wait for next call; does nothing when called from within a coroutine
+	Int RunCoroutines();
+	// suspend running coroutine until next RunCoroutines; returns false if not in coroutine
+	// or if coroutine is being cancelled (context reset or destroyed), scripts should return then
+	bool YieldCoroutine();
+	inline bool InCoroutine() const {return activeCoroutine != nullptr;}
+	inline Int GetCoroutineCount() const {return coroutines.GetSize();}
+
+	// arena scopes: while a scope is open, script new allocates from a bump allocator owned by the context
+	// (arena_call in script opens one for the duration of a delegate call); scopes nest and must be closed in order
+	// dtors and refcounting work as usual, EndArena destroys objects still alive but unreachable from outside
+	// (cycles) in bulk and resets the arena
+	// objects referenced from outside at that point escape with everything reachable from them: they're left alive
+	// and keep the whole arena alive; reported via engine onInfo in debug mode
+	void BeginArena();
+	// returns number of escaped objects or -1 if no scope is open
+	Int EndArena();
+	inline Int GetArenaDepth() const {return arenas.GetSize();}
+	// number of arenas kept alive by escaped objects; they're recycled by EndArena and Reset
+	// once the escaped objects are released
+	inline Int GetRetiredArenaCount() const {return retiredArenas.GetSize();}
+	// allocate object memory in innermost arena (used by script new), scope must be open
+	inline void *AllocArenaObject(size_t size);
+
 	inline ScriptEngine &GetEngine() const {return *engine;}
 
 	// get function signature for a function
@@ -205,6 +262,9 @@ private:
 	HashMap<Int, ProfileInfo> profiling;
 	Int profParent = -1;
 
+	// print profiling results via engine onInfo
+	void ReportProfiling() const;
+
 	friend class ScriptEngine;
 
 	String debugName;
@@ -223,10 +283,61 @@ private:
 
 	ScriptDelegate *stateDelegateRef;
 
+	bool deferRelease = false;
+	Array<BaseObject *> deferredReleases;
+
+	void DestroyDeferred(BaseObject *obj);
+	// call script dtor within this context
+	void CallObjectDtor(BaseObject *obj);
+
+	// open arena scopes, innermost last
+	Array<SharedPtr<ArenaAlloc>> arenas;
+	// objects allocated in open scopes, arenaStarts holds first index for each scope
+	Array<BaseObject *> arenaObjects;
+	Array<Int> arenaStarts;
+	// reset arenas kept for reuse
+	Array<SharedPtr<ArenaAlloc>> freeArenas;
+	// arenas backing escaped objects, recycled once all of them are gone
+	struct RetiredArena
+	{
+		SharedPtr<ArenaAlloc> arena;
+		Array<BaseObject *> objects;
+	};
+	Array<RetiredArena> retiredArenas;
+
+	struct Coroutine;
+	// live coroutines in start order
+	Array<Coroutine *> coroutines;
+	// finished coroutines kept for reuse (stacks stay allocated)
+	Array<Coroutine *> freeCoroutines;
+	Coroutine *activeCoroutine = nullptr;
+	Int coStackSize = 16*1024;
+	// note: string formatting alone uses 64k buffers on native stack
+	Int coNativeStackSize = 256*1024;
+
+	// yields failing in a row before a cancelled coroutine is abandoned
+	static const Int MAX_CANCEL_YIELDS = 4096;
+
+	void ResumeCoroutine(Coroutine &co);
+	void FinishCoroutine(Coroutine &co);
+	// resume suspended coroutines once with coroutine_yield returning false so they can return normally,
+	// releasing their locals; used by Reset and dtor
+	void CancelCoroutines();
+	// recycle retired arenas whose escaped objects are all gone
+	void ReclaimRetiredArenas();
 	void OnRuntimeError(const char *msg);
 	bool OnDebugBreak(ScriptContext &ctx, ExecResult &res);
 };
 
+void *ScriptContext::AllocArenaObject(size_t size)
+{
+	// header words make the block look foreign to ObjectHeap
+	auto *res = static_cast<Byte *>(arenas.Back()->Alloc(size + ObjectPool::MAX_ALIGN, ObjectPool::MAX_ALIGN)) + ObjectPool::MAX_ALIGN;
+	ObjectPool::MarkForeign(res);
+	arenaObjects.Add(reinterpret_cast<BaseObject *>(res));
+	return res;
+}
+
 LETHE_API_END
 
 }
@@ -3,8 +3,10 @@
 #include "TypeInfo/BaseObject.h"
 #include "Utils/NativeHelpers.h"
 #include "Vm/Builtin.h"
+#include "Program/HeapProfiler.h"
 
 #include <Lethe/Core/String/StringRef.h>
+#include <Lethe/Core/String/StringBuilder.h>
 #include <Lethe/Core/Memory/Heap.h>
 #include <Lethe/Core/Io/VfsFile.h>
 #include <Lethe/Core/Io/MemoryStream.h>
@@ -191,6 +193,18 @@ nodiscard native string func_name_from_delegate(void delegate() dg);
 nodiscard native static bool class_name_is(name test, name n);
 nodiscard native static bool class_name_is_anyof(name test, const name[] n);
 
+// coroutines (scheduled via ScriptContext::RunCoroutines)
+// start delegate as new coroutine; first runs on next scheduler tick
+native bool coroutine_start(void delegate() dg);
+// suspend current coroutine until next scheduler tick; returns false if not inside a coroutine
+// or if it's being cancelled (context reset/destroyed), return then so that locals are destroyed
+native bool coroutine_yield();
+nodiscard native bool in_coroutine();
+
+// run delegate in arena scope: objects created via new are bump-allocated and destroyed in bulk when it returns
+// returns number of objects still referenced from outside (their memory is kept alive)
+native int arena_call(void delegate() dg);
+
 // mark args/vars as unused to avoid compiler warnings
 native __intrinsic void unused(...);
 
@@ -370,6 +384,7 @@ typedef const uintptr const_uintptr;
 
 ScriptEngine::~ScriptEngine()
 {
+	ClearContextPool();
 	stockCtx = nullptr;
 	LETHE_ASSERT(contexts.IsEmpty());
 }
@@ -380,6 +395,15 @@ bool ScriptEngine::EnableRuntimeChecks(bool enable)
 		return false;
 
 	program->SetUnsafe(!enable);
+
+	if (!enable)
+	{
+		MutexLock lock(contextMutex);
+
+		for (auto *it : contexts)
+			it->vmStack->CommitAll();
+	}
+
 	return true;
 }
 
@@ -389,6 +413,53 @@ void ScriptEngine::EnableInlineExpansion(bool enable)
 		program->inlineExpansionAllowed = enable;
 }
 
+void ScriptEngine::EnableStackObjects(bool enable)
+{
+	if (program)
+		program->stackObjectsAllowed = enable;
+}
+
+void ScriptEngine::EnableRefCountElision(bool enable)
+{
+	if (program)
+		program->refCountElisionAllowed = enable;
+}
+
+void ScriptEngine::EnableTailCalls(bool enable)
+{
+	if (program)
+		program->tailCallsAllowed = enable;
+}
+
+void ScriptEngine::EnableReadOnlyData(bool enable)
+{
+	if (program)
+		program->readOnlyDataAllowed = enable;
+}
+
+void ScriptEngine::EnableFieldReordering(bool enable)
+{
+	if (program)
+		program->fieldReordering = enable;
+}
+
+void ScriptEngine::EnableHeapProfiling(bool enable)
+{
+	if (!program || enable == program->HeapProfilingEnabled())
+		return;
+
+	auto &cpool = program->cpool;
+
+	delete cpool.heapProfiler;
+	cpool.heapProfiler = enable ? new HeapProfiler : nullptr;
+}
+
+void ScriptEngine::KeepFunction(const String &fname)
+{
+	if (program)
+		program->keepFuncs.Add(fname);
+}
+
 String ScriptEngine::GetInternalProgram() const
 {
 	return internalProg;
@@ -603,6 +674,10 @@ void *ScriptEngine::FindGlobalVariable(const String &n) const
 		{
 			auto offset = it->value.offset;
 
+			// note: read-only data is write-protected
+			if (it->value.readOnly)
+				return const_cast<Byte *>(program->cpool.GetReadOnlyData()) + offset;
+
 			return program->cpool.data.GetData() + offset;
 		}
 	}
@@ -721,6 +796,31 @@ bool ScriptEngine::CompileStream(Stream &stream, const String &filename)
 	return res;
 }
 
+void ScriptEngine::GatherAstMemoryStats()
+{
+	auto &cs = compileStats;
+	cs.astNodeCount = cs.astNodeBytes = 0;
+	MemSet(cs.astTypeCount, 0, sizeof(cs.astTypeCount));
+	MemSet(cs.astTypeBytes, 0, sizeof(cs.astTypeBytes));
+	cs.astArenaBytes = (Long)compiler->GetAstArenaUsage();
+
+	const auto *root = compiler->GetRootNode();
+
+	if (!root)
+		return;
+
+	AstConstIterator it(root);
+
+	while (const auto *n = it.Next())
+	{
+		auto bytes = (Long)n->GetMemUsage();
+		++cs.astNodeCount;
+		cs.astNodeBytes += bytes;
+		++cs.astTypeCount[n->type];
+		cs.astTypeBytes[n->type] += bytes;
+	}
+}
+
 bool ScriptEngine::Link(int linkFlags)
 {
 	LETHE_RET_FALSE(compiler);
@@ -770,6 +870,8 @@ bool ScriptEngine::Link(int linkFlags)
 	if (!(linkFlags & LINK_SKIP_CODEGEN))
 	{
 		pw.Start();
+		program->stripUnreferenced = (linkFlags & LINK_STRIP_UNREFERENCED) != 0;
+		program->foldIdenticalFuncs = (linkFlags & LINK_FOLD_IDENTICAL) != 0;
 		LETHE_RET_FALSE(compiler->CodeGen(*program));
 		compileStats.codeGenTime += Double(pw.Stop()) / 1000000.0;
 
@@ -789,6 +891,9 @@ bool ScriptEngine::Link(int linkFlags)
 		}
 	}
 
+	if (linkFlags & LINK_AST_MEMORY_STATS)
+		GatherAstMemoryStats();
+
 	if (!(linkFlags & LINK_KEEP_COMPILER))
 	{
 		pw.Start();
@@ -849,9 +954,14 @@ NativeClassProxy ScriptEngine::BindNativeStruct(const String &cname, size_t size
 }
 
 // create new script execution context
-SharedPtr<ScriptContext> ScriptEngine::CreateContext(Int stkSize)
+SharedPtr<ScriptContext> ScriptEngine::CreateContext(Int stkSize, Int maxStkSize)
 {
-	ScriptContext *res = new ScriptContext(stkSize);
+	ScriptContext *res = new ScriptContext(stkSize, maxStkSize);
+
+	// no stack checks => can't grow
+	if (program->GetUnsafe())
+		res->vmStack->CommitAll();
+
 	res->engine = this;
 	res->vmJit = vmJit;
 	res->mode = mode;
@@ -870,6 +980,84 @@ SharedPtr<ScriptContext> ScriptEngine::CreateContext(Int stkSize)
 	return res;
 }
 
+SharedPtr<ScriptContext> ScriptEngine::AcquireContext(Int stkSize, Int maxStkSize)
+{
+	if (stkSize <= 0)
+		stkSize = 65536;
+
+	const Int needSize = Max(stkSize, maxStkSize);
+
+	{
+		SpinMutexLock lock(poolMutex);
+
+		// most recently released first
+		for (Int i=contextPool.GetSize()-1; i>=0; i--)
+		{
+			if (contextPool[i]->vmStack->GetMaxSize() < needSize)
+				continue;
+
+			SharedPtr<ScriptContext> res = contextPool[i];
+			contextPool.EraseIndex(i);
+			return res;
+		}
+	}
+
+	return CreateContext(stkSize, maxStkSize);
+}
+
+bool ScriptEngine::ReleaseContext(SharedPtr<ScriptContext> &ctx)
+{
+	if (!ctx)
+		return true;
+
+	// resetting a context someone else still uses would pull its state from under it
+	if (RefCounted::GetStrongRefCount(ctx.Get()) != 1)
+	{
+		LETHE_ASSERT(false && "releasing shared context");
+		return false;
+	}
+
+	SharedPtr<ScriptContext> tmp;
+	tmp.SwapWith(ctx);
+
+	if (tmp->engine != this || !tmp->Reset())
+		return true;
+
+	SpinMutexLock lock(poolMutex);
+
+	if (contextPool.GetSize() < contextPoolSize)
+		contextPool.Add(tmp);
+
+	return true;
+}
+
+void ScriptEngine::SetContextPoolSize(Int maxSize)
+{
+	// destroyed outside of lock
+	Array<SharedPtr<ScriptContext>> tmp;
+
+	{
+		SpinMutexLock lock(poolMutex);
+		contextPoolSize = Max<Int>(maxSize, 0);
+
+		while (contextPool.GetSize() > contextPoolSize)
+		{
+			tmp.Add(contextPool[0]);
+			contextPool.EraseIndex(0);
+		}
+	}
+}
+
+void ScriptEngine::ClearContextPool()
+{
+	Array<SharedPtr<ScriptContext>> tmp;
+
+	{
+		SpinMutexLock lock(poolMutex);
+		tmp.SwapWith(contextPool);
+	}
+}
+
 void ScriptEngine::ClearCompiler()
 {
 	compiler.Clear();
@@ -880,6 +1068,154 @@ bool ScriptEngine::GetJitCode(const Byte *&ptr, Int &size)
 	return vmJit ? vmJit->GetJitCode(ptr, size) : false;
 }
 
+bool ScriptEngine::GetReadOnlyData(const Byte *&ptr, Int &size) const
+{
+	LETHE_RET_FALSE(program);
+
+	ptr = program->cpool.GetReadOnlyData();
+	size = program->cpool.GetReadOnlyDataSize();
+	return ptr != nullptr;
+}
+
+struct ScriptEngine_LayoutSlot
+{
+	const DataType::Member *member;
+	Int size;
+	Int align;
+
+	bool operator <(const ScriptEngine_LayoutSlot &o) const
+	{
+		return align > o.align || (align == o.align && member < o.member);
+	}
+};
+
+void ScriptEngine::ReportTypeLayouts() const
+{
+	if (!program)
+		return;
+
+	const Int cacheLine = 64;
+
+	for (auto &&it : program->types)
+	{
+		const auto &dt = *it;
+
+		if ((dt.type != DT_STRUCT && dt.type != DT_CLASS) || (dt.structQualifiers & AST_Q_NATIVE) || dt.members.IsEmpty())
+			continue;
+
+		Int start = dt.baseType.GetTypeEnum() != DT_NONE ? dt.baseType.GetSize() : 0;
+		Int memberSize = 0;
+		bool hasBitfields = false;
+		bool hasHotCold = false;
+
+		StackArray<ScriptEngine_LayoutSlot, 32> slots;
+
+		for (auto &&m : dt.members)
+		{
+			if (m.type.IsProperty())
+				continue;
+
+			hasBitfields |= m.bitSize > 0;
+
+			// bitfields packed into previous member
+			if (m.bitOffset)
+				continue;
+
+			hasHotCold |= Attributes::Has(m.attributes, "hot") || Attributes::Has(m.attributes, "cold");
+
+			ScriptEngine_LayoutSlot slot;
+			slot.member = &m;
+			slot.size = m.type.GetSize();
+			slot.align = m.type.GetAlign();
+
+			// empty structs take one byte
+			if (!slot.size)
+				slot.size = slot.align = 1;
+
+			memberSize += slot.size;
+			slots.Add(slot);
+		}
+
+		if (slots.IsEmpty())
+			continue;
+
+		onInfo(String::Printf("%s %s: size %d, align %d, padding %d bytes", dt.type == DT_STRUCT ? "struct" : "class",
+			dt.name.Ansi(), dt.size, dt.align, dt.size - start - memberSize));
+
+		if (!hasBitfields)
+		{
+			slots.Sort();
+
+			Int ofs = start;
+
+			for (auto &&sit : slots)
+			{
+				ofs = (ofs + sit.align - 1) / sit.align * sit.align;
+				ofs += sit.size;
+			}
+
+			ofs = (ofs + dt.align - 1) / dt.align * dt.align;
+
+			if (ofs < dt.size)
+			{
+				StringBuilder sb;
+				sb.AppendFormat("    reordering by alignment saves %d bytes:", dt.size - ofs);
+
+				for (auto &&sit : slots)
+					sb.AppendFormat(" %s", sit.member->name.Ansi());
+
+				onInfo(sb.Get());
+			}
+		}
+
+		if (dt.size <= cacheLine)
+			continue;
+
+		StringBuilder hot;
+		StringBuilder cold;
+
+		for (auto &&sit : slots)
+		{
+			const auto &m = *sit.member;
+
+			if (Attributes::Has(m.attributes, "hot") && m.offset + sit.size > cacheLine)
+				hot.AppendFormat(" %s", m.name.Ansi());
+
+			if (Attributes::Has(m.attributes, "cold") && m.offset < cacheLine)
+				cold.AppendFormat(" %s", m.name.Ansi());
+		}
+
+		Int lines = (dt.size + cacheLine - 1) / cacheLine;
+
+		if (!hasHotCold)
+			onInfo(String::Printf("    spans %d cache lines; mark frequently used members [hot] and rarely used ones [cold]", lines));
+
+		if (hot.GetLength())
+			onInfo(String::Printf("    spans %d cache lines; hot members past first cache line:%s", lines, hot.Ansi()));
+
+		if (cold.GetLength())
+			onInfo(String::Printf("    cold members in first cache line:%s", cold.Ansi()));
+	}
+}
+
+void ScriptEngine::ReportHeapProfile(Int maxEntries) const
+{
+	if (!program || !program->cpool.heapProfiler)
+		return;
+
+	Array<String> lines;
+	program->cpool.heapProfiler->Report(lines, maxEntries);
+
+	for (auto &&it : lines)
+		onInfo(it);
+}
+
+void ScriptEngine::ResetHeapProfile()
+{
+	if (program && program->cpool.heapProfiler)
+		program->cpool.heapProfiler->Reset();
+}
+
 Int ScriptEngine::FindFunctionOffset(const StringRef &fname) const
 {
 	if (!program)
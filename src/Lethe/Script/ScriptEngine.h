@@ -3,6 +3,7 @@
 #include <Lethe/Core/Collect/FreeIdList.h>
 
 #include "ScriptContext.h"
+#include "Ast/AstNode.h"
 #include "DebugServer/DebugServer.h"
 
 namespace lethe
@@ -17,7 +18,14 @@ enum LinkFlags
 	// keep compiler and AST in memory
 	LINK_KEEP_COMPILER = 2,
 	// clone AST for find definition
-	LINK_CLONE_AST_FIND_DEFINITION = 4
+	LINK_CLONE_AST_FIND_DEFINITION = 4,
+	// collect AST memory stats (see CompileStats)
+	LINK_AST_MEMORY_STATS = 8,
+	// don't generate code for functions unreachable from global code, virtual methods and keep list
+	// (see KeepFunction); function-level only: all types and all virtual methods are kept
+	LINK_STRIP_UNREFERENCED = 16,
+	// merge template instance functions that generate identical code
+	LINK_FOLD_IDENTICAL = 32
 };
 
 enum SingleStepMode
@@ -41,6 +49,16 @@ struct CompileStats
 	Double jitTime;
 	// cleanup time (freeing memory)
 	Double cleanupTime;
+
+	// AST memory, only collected with LINK_AST_MEMORY_STATS
+	// node count and bytes (including allocation header and out of line child arrays)
+	Long astNodeCount;
+	Long astNodeBytes;
+	// AST arena size in bytes
+	Long astArenaBytes;
+	// per node type breakdown, see AstNode::GetTypeName
+	Long astTypeCount[AST_MAX];
+	Long astTypeBytes[AST_MAX];
 };
 
 class ScriptEngine;
@@ -102,6 +120,36 @@ public:
 	// enable inline function expansion? on by default for all modes
 	void EnableInlineExpansion(bool enable);
 
+	// allocate objects that provably don't escape a function in its stack frame? on by default
+	// such objects skip refcounting and onNewObject
+	void EnableStackObjects(bool enable);
+
+	// elide reference counting for local strong pointers copied from a reference that outlives them? on by default
+	void EnableRefCountElision(bool enable);
+
+	// turn calls in tail position into jumps when frames are compatible? on by default
+	// such calls don't show up in call stacks
+	void EnableTailCalls(bool enable);
+
+	// place constant globals with constant initializers in read-only data? on by default
+	// read-only data is write-protected and shared between engines that compile identical data
+	void EnableReadOnlyData(bool enable);
+
+	// reorder fields of script structs/classes by alignment to minimize padding? off by default
+	// must be called before compiling; types bound natively and types with bitfields keep declaration order
+	// so do types used in native function signatures or native vars (unless marked [reorder])
+	// per type: [reorder] enables, [no_reorder] disables; members marked [hot] go first, [cold] last
+	void EnableFieldReordering(bool enable);
+
+	// track per-class and per-callsite statistics of objects created via new? off by default
+	// must be called before compiling; see ReportHeapProfile
+	// disables stack objects (see EnableStackObjects) so that every new is counted
+	void EnableHeapProfiling(bool enable);
+
+	// keep function when linking with LINK_STRIP_UNREFERENCED (fully qualified name)
+	// functions called from C++ must be added here
+	void KeepFunction(const String &fname);
+
 	// compile file/stream
 	bool CompileBuffer(const char *buf, const String &filename);
 	bool CompileFile(const String &filename);
@@ -161,7 +209,21 @@ public:
 
 	// create new script execution context
 	// stkSize = desired stack size in stack words, 0 = default
-	SharedPtr<ScriptContext> CreateContext(Int stkSize = 0);
+	// maxStkSize = reserved stack size in stack words, stack grows up to this size, 0 = fixed size
+	// growing needs runtime checks; without them, the whole range is committed (pages are still mapped lazily by the OS)
+	SharedPtr<ScriptContext> CreateContext(Int stkSize = 0, Int maxStkSize = 0);
+
+	// context pool: get an idle context, reusing released ones (with their stack memory) if possible
+	// stkSize, maxStkSize as in CreateContext; pooled contexts stay registered, so the fast path only takes a spin lock
+	SharedPtr<ScriptContext> AcquireContext(Int stkSize = 0, Int maxStkSize = 0);
+	// reset context and return it to pool (ctx is cleared); context must not be executing
+	// and ctx must be the only reference; pool is bounded, extra contexts are destroyed
+	// returns false (ctx is left untouched) if there are other references
+	bool ReleaseContext(SharedPtr<ScriptContext> &ctx);
+	// max number of pooled contexts, default is 16
+	void SetContextPoolSize(Int maxSize);
+	// destroy all pooled contexts
+	void ClearContextPool();
 
 	// get created script contexts
 	Array<SharedPtr<ScriptContext>> GetContexts() const;
@@ -172,6 +234,18 @@ public:
 	// special JIT functions:
 	bool GetJitCode(const Byte *&ptr, Int &size);
 
+	// read-only data of linked program (page-aligned); returns false if none
+	bool GetReadOnlyData(const Byte *&ptr, Int &size) const;
+
+	// report size, padding and layout suggestions for script structs/classes via onInfo
+	void ReportTypeLayouts() const;
+
+	// report live objects, bytes and allocation rates per class and allocation site via onInfo
+	// maxEntries limits number of classes and sites listed
+	void ReportHeapProfile(Int maxEntries = 20) const;
+	// reset heap profile counters; live objects stay tracked
+	void ResetHeapProfile();
+
 	ScriptContext &GetStockContext();
 
 	// convert (delegate) method index to pointer
@@ -298,6 +372,11 @@ private:
 	mutable Mutex contextMutex;
 	Array<ScriptContext *> contexts;
 
+	// idle contexts for reuse
+	SpinMutex poolMutex;
+	Array<SharedPtr<ScriptContext>> contextPool;
+	Int contextPoolSize = 16;
+
 	mutable Mutex breakpointMutex;
 	Array<ScriptBreakpoint> breakpoints;
 	FreeIdList freeBreakpoints;
@@ -313,6 +392,8 @@ private:
 	void OnCompile(const String &filename);
 	void OnResolve(Int steps);
 
+	void GatherAstMemoryStats();
+
 	Int SetBreakpointInternal(const String &nfilename, Int npc, bool enabled);
 };
 
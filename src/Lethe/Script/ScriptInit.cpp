@@ -4,6 +4,7 @@
 #include <Lethe/Core/Thread/Lock.h>
 #include <Lethe/Core/Time/Timer.h>
 #include <Lethe/Core/String/Name.h>
+#include <Lethe/Core/Lexer/Token.h>
 #include <Lethe/Core/String/CharConv.h>
 #include <Lethe/Core/Classes/ObjectHeap.h>
 #include <Lethe/Core/Memory/BucketAlloc.h>
@@ -32,6 +33,7 @@ void Init(const InitOptions *opts)
 	Timer::Init();
 	CharConv::Init();
 	NameTable::Init();
+	TokenFileTable::Init();
 	ObjectHeap::Init();
 }
 
@@ -41,6 +43,7 @@ void Done()
 		return;
 
 	ObjectHeap::Done();
+	TokenFileTable::Done();
 	NameTable::Done();
 	CharConv::Done();
 	Timer::Done();
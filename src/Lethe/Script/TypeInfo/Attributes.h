@@ -41,6 +41,19 @@ struct LETHE_API Attributes : RefCounted
 {
 	// attributes are pre-parsed as lexer tokens
 	Array<AttributeToken> tokens;
+
+	// true if attrs (can be null) contain identifier name
+	static bool Has(const Attributes *attrs, const char *name)
+	{
+		if (!attrs)
+			return false;
+
+		for (auto &&it : attrs->tokens)
+			if (it.type == TOK_IDENT && it.text == name)
+				return true;
+
+		return false;
+	}
 };
 
 LETHE_API_END
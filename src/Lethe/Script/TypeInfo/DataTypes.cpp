@@ -70,6 +70,8 @@ bool DataType::MatchType(const DataType &o, bool narrowStatic) const
 	if (type == DT_ARRAY_REF || type == DT_DYNAMIC_ARRAY)
 	{
 		LETHE_RET_FALSE(o.type == DT_ARRAY_REF);
+		// soa storage can't be viewed as array ref
+		LETHE_RET_FALSE(type != DT_DYNAMIC_ARRAY || !elemType.GetType().IsSoa());
 		return elemType.GetType() == o.elemType.GetType();
 	}
 
@@ -470,6 +472,31 @@ bool DataType::IsEnumFlags() const
 	return false;
 }
 
+const DataType::SoaField *DataType::FindSoaField(Long offset) const
+{
+	for (auto &&it : soaFields)
+		if (it.offset == offset)
+			return &it;
+
+	return nullptr;
+}
+
+void DataType::SoaLoad(void *dst, const Byte *data, Int capacity, Int index) const
+{
+	auto *bdst = static_cast<Byte *>(dst);
+
+	for (auto &&it : soaFields)
+		MemCpy(bdst + it.offset, data + (size_t)capacity*it.soaOffset + (size_t)index*it.size, it.size);
+}
+
+void DataType::SoaStore(Byte *data, Int capacity, Int index, const void *src) const
+{
+	auto *bsrc = static_cast<const Byte *>(src);
+
+	for (auto &&it : soaFields)
+		MemCpy(data + (size_t)capacity*it.soaOffset + (size_t)index*it.size, bsrc + it.offset, it.size);
+}
+
 void DataType::GenBaseChain() const
 {
 	isa.Clear();
@@ -988,8 +1015,17 @@ bool DataType::GenDtor(CompiledProgram &p) const
 
 		// handle object counter if base object
 		if (type == DT_CLASS && typeName == "object")
+		{
 			p.EmitI24(OPC_BCALL, BUILTIN_DEC_OBJECT_COUNTER);
 
+			if (p.HeapProfilingEnabled())
+			{
+				// push original ptr, loaded ptr is on top
+				p.Emit(OPC_LPUSHPTR + (UInt(firstArg+1) << 8));
+				p.EmitI24(OPC_BCALL, BUILTIN_HEAP_PROF_FREE);
+			}
+		}
+
 		if (base && !native)
 		{
 			p.Emit(OPC_POP + (1 << 8));
@@ -1659,6 +1695,8 @@ bool QDataType::CanAssign(const QDataType &o, bool allowPointers, bool strictStr
 	{
 		// make sure we don't cast out const
 		LETHE_RET_FALSE(ref->elemType.IsConst() || !o.ref->elemType.IsConst());
+		// soa storage can't be viewed as array ref
+		LETHE_RET_FALSE(o.GetTypeEnum() != DT_DYNAMIC_ARRAY || !o.ref->elemType.GetType().IsSoa());
 
 		return *ref->elemType.ref == *o.ref->elemType.ref;
 	}
@@ -1666,6 +1704,7 @@ bool QDataType::CanAssign(const QDataType &o, bool allowPointers, bool strictStr
 	if (dte == DT_DYNAMIC_ARRAY)
 	{
 		LETHE_RET_FALSE(o.GetTypeEnum() == DT_DYNAMIC_ARRAY || o.GetTypeEnum() == DT_ARRAY_REF);
+		LETHE_RET_FALSE(o.GetTypeEnum() == DT_DYNAMIC_ARRAY || !ref->elemType.GetType().IsSoa());
 
 		return *ref->elemType.ref == *o.ref->elemType.ref;
 	}
@@ -2086,14 +2125,34 @@ void DataType::GetVariableTextInternal(Int bitfld, bool skipReadCheck, HashSet<c
 
 		bptr = aref->GetData();
 
-		if (!ValidReadPtr(bptr, (IntPtr)count * elemType.GetSize()))
+		// structure-of-arrays elements are gathered into a temporary
+		const auto &etype = elemType.GetType();
+		const bool soa = type == DT_DYNAMIC_ARRAY && etype.IsSoa();
+		IntPtr readSize = (IntPtr)count * elemType.GetSize();
+		Int capacity = 0;
+		Array<Byte> soaElem;
+
+		if (soa)
+		{
+			// header: data, size, reserve
+			capacity = reinterpret_cast<const Int *>(static_cast<const Byte *>(ptr) + sizeof(void *))[1];
+			readSize = (IntPtr)capacity * (etype.soaFields.Back().soaOffset + etype.soaFields.Back().size);
+			soaElem.Resize(etype.size, 0);
+		}
+
+		if (!ValidReadPtr(bptr, readSize))
 			sb += '?';
 		else
 		{
 			for (Int i = 0; i<count; i++)
 			{
+				if (soa)
+				{
+					etype.SoaLoad(soaElem.GetData(), bptr, capacity, i);
+					etype.GetVariableTextInternal(0, true, hset, sb, soaElem.GetData(), maxLen);
+				}
 				// avoid infinite recursion
-				if (hset.FindIndex(bptr) >= 0)
+				else if (hset.FindIndex(bptr) >= 0)
 					sb += "?";
 				else
 					elemType.GetType().GetVariableTextInternal(0, true, hset, sb, bptr, maxLen);
@@ -2210,7 +2269,8 @@ void DataType::GetVariableTextInternal(Int bitfld, bool skipReadCheck, HashSet<c
 
 size_t DataType::GetMemUsage() const
 {
-	return sizeof(*this) + isa.GetMemUsage() + argTypes.GetMemUsage() + members.GetMemUsage() + methods.GetMemUsage();
+	return sizeof(*this) + isa.GetMemUsage() + argTypes.GetMemUsage() + members.GetMemUsage() + methods.GetMemUsage() +
+		soaFields.GetMemUsage();
 }
 
 const DataType *DataType::GetPointerType(DataTypeEnum dte) const
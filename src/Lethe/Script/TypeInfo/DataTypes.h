@@ -270,6 +270,19 @@ public:
 
 	// for structs/classes:
 	Array<Member> members;
+
+	// structure-of-arrays field, one per struct member (including base members)
+	struct SoaField
+	{
+		// offset within struct
+		Int offset;
+		Int size;
+		// field block starts at data + capacity*soaOffset
+		Int soaOffset;
+	};
+
+	// for [soa] structs only: dynamic arrays store each field in a separate block
+	Array<SoaField> soaFields;
 	// for classes only:
 	// value: PC offset; 0 = none, <0 => -vtbl index, otherwise PC of final function
 	HashMap<String, Int> methods;
@@ -337,6 +350,16 @@ public:
 	// is enum flags?
 	bool IsEnumFlags() const;
 
+	// is struct stored as structure-of-arrays in dynamic arrays?
+	inline bool IsSoa() const {return !soaFields.IsEmpty();}
+
+	// find soa field for member offset, null if none
+	const SoaField *FindSoaField(Long offset) const;
+
+	// gather/scatter soa element
+	void SoaLoad(void *dst, const Byte *data, Int capacity, Int index) const;
+	void SoaStore(Byte *data, Int capacity, Int index, const void *src) const;
+
 	// has array ref with any non-const element?
 	bool HasArrayRefWithNonConstElem() const;
 
@@ -93,7 +93,9 @@ enum AstQualifier : ULong
 	AST_Q_THREAD_UNSAFE = (ULong)1 << 54,
 	// thread-call function (cannot call thread-unsafe functions)
 	AST_Q_THREAD_CALL = (ULong)1 << 55,
-	// note: 8 left
+	// var decl: constant global placed in read-only data
+	AST_Q_READ_ONLY = (ULong)1 << 56,
+	// note: 7 left
 
 	// func decl inherit mask
 	AST_Q_FUNC_MASK	= AST_Q_STATIC | AST_Q_NATIVE | AST_Q_VIRTUAL | AST_Q_FINAL | AST_Q_CTOR | AST_Q_DTOR |
@@ -71,6 +71,10 @@ struct DynamicArray
 	void Reverse(const DataType &dt);
 	void Sort(ScriptContext &ctx, const DataType &dt);
 
+	// structure-of-arrays storage ([soa] structs, POD only)
+	void ReallocateSoa(const DataType &dt, Int newReserve);
+	void ZeroSoaRange(const DataType &dt, Int start, Int elemCount);
+
 	// element construction
 
 	static void ConstructObjectRange(ScriptContext &ctx, const DataType &dt, Byte *ptr, Int elemCount);
@@ -189,11 +193,51 @@ DynamicArray::compareFunc DynamicArray::GetCompareFuncInternal(ScriptContext &ct
 	return nullptr;
 }
 
+void DynamicArray::ReallocateSoa(const DataType &dt, Int newReserve)
+{
+	const auto &last = dt.soaFields.Back();
+	size_t rowSize = (size_t)last.soaOffset + last.size;
+
+	Byte *newData = newReserve ? static_cast<Byte *>(AlignedAlloc::Alloc(newReserve * rowSize, dt.align)) : nullptr;
+	Int newSize = newData ? Min(size, newReserve) : 0;
+
+	// field blocks depend on capacity => move each one
+	for (auto &&it : dt.soaFields)
+		if (newSize)
+			MemCpy(newData + (size_t)newReserve*it.soaOffset, data + (size_t)GetCapacity()*it.soaOffset, (size_t)newSize*it.size);
+
+	if (data && reserve > 0)
+		AlignedAlloc::Free(data);
+
+	reserve = newReserve;
+	size = newSize;
+	data = newData;
+}
+
+void DynamicArray::ZeroSoaRange(const DataType &dt, Int start, Int elemCount)
+{
+	if (elemCount <= 0)
+		return;
+
+	LETHE_ASSERT(data);
+
+	for (auto &&it : dt.soaFields)
+		MemSet(data + (size_t)GetCapacity()*it.soaOffset + (size_t)start*it.size, 0, (size_t)elemCount*it.size);
+}
+
 void DynamicArray::Resize(ScriptContext &ctx, const DataType &dt, Int newSize)
 {
 	LETHE_ASSERT(newSize >= 0);
 	newSize = MaxZero(newSize);
 
+	if (dt.IsSoa())
+	{
+		Reserve(ctx, dt, newSize);
+		ZeroSoaRange(dt, size, newSize - size);
+		size = newSize;
+		return;
+	}
+
 	size_t sz = dt.size;
 
 	if (size > newSize)
@@ -212,6 +256,12 @@ void DynamicArray::Reallocate(ScriptContext &ctx, const DataType &dt, Int newRes
 	if (newReserve == GetCapacity())
 		return;
 
+	if (dt.IsSoa())
+	{
+		ReallocateSoa(dt, newReserve);
+		return;
+	}
+
 	size_t sz = dt.size;
 
 	Byte *newData = newReserve ?
@@ -387,6 +437,13 @@ Int DynamicArray::Push(ScriptContext &ctx, const DataType &dt, const void *value
 	if (LETHE_UNLIKELY(size >= GetCapacity()))
 		Reserve(ctx, dt, size + 1);
 
+	if (dt.IsSoa())
+	{
+		LETHE_ASSERT(data);
+		dt.SoaStore(data, GetCapacity(), size, valuePtr);
+		return size++;
+	}
+
 	auto dptr = data + size*(size_t)dt.size;
 	ConstructObjectRange(ctx, dt, dptr, 1);
 	LETHE_ASSERT(data);
@@ -616,6 +673,18 @@ bool DynamicArray::Erase(ScriptContext &ctx, const DataType &dt, Int index)
 
 	LETHE_ASSERT(data);
 
+	if (dt.IsSoa())
+	{
+		for (auto &&it : dt.soaFields)
+		{
+			auto *fdata = data + (size_t)GetCapacity()*it.soaOffset;
+			MemMove(fdata + (size_t)index*it.size, fdata + ((size_t)index + 1)*it.size, ((size_t)size - index - 1)*it.size);
+		}
+
+		size--;
+		return true;
+	}
+
 	size_t sz = dt.size;
 
 	auto dptr = data + index*sz;
@@ -636,6 +705,18 @@ bool DynamicArray::EraseUnordered(ScriptContext &ctx, const DataType &dt, Int in
 
 	LETHE_ASSERT(data);
 
+	if (dt.IsSoa())
+	{
+		for (auto &&it : dt.soaFields)
+		{
+			auto *fdata = data + (size_t)GetCapacity()*it.soaOffset;
+			MemCpy(fdata + (size_t)index*it.size, fdata + ((size_t)size-1)*it.size, it.size);
+		}
+
+		size--;
+		return true;
+	}
+
 	size_t sz = dt.size;
 
 	auto dptr = data + index*sz;
@@ -1699,6 +1780,37 @@ static void natClassNameIsAnyOf(Stack &stk)
 	}
 }
 
+static void natCoroutineStart(Stack &stk)
+{
+	ArgParser ap(stk);
+	auto dg = ap.Get<ScriptDelegate>();
+	ap.Get<bool>() = stk.GetContext().StartCoroutine(dg);
+}
+
+static void natCoroutineYield(Stack &stk)
+{
+	// note: stack stays valid while suspended, it's owned by the coroutine
+	ArgParser ap(stk);
+	ap.Get<bool>() = stk.GetContext().YieldCoroutine();
+}
+
+static void natInCoroutine(Stack &stk)
+{
+	ArgParser ap(stk);
+	ap.Get<bool>() = stk.GetContext().InCoroutine();
+}
+
+static void natArenaCall(Stack &stk)
+{
+	ArgParser ap(stk);
+	auto dg = ap.Get<ScriptDelegate>();
+	auto &ctx = stk.GetContext();
+
+	ctx.BeginArena();
+	ctx.CallDelegate(dg);
+	ap.Get<Int>() = ctx.EndArena();
+}
+
 void NativeHelpers::Init(CompiledProgram &p)
 {
 	p.cpool.BindNativeFunc("decode_utf8", native_decodeUtf8);
@@ -1764,6 +1876,12 @@ void NativeHelpers::Init(CompiledProgram &p)
 	// callstack:
 	p.cpool.BindNativeFunc("callstack", natCallstack);
 
+	// coroutines:
+	p.cpool.BindNativeFunc("coroutine_start", natCoroutineStart);
+	p.cpool.BindNativeFunc("coroutine_yield", natCoroutineYield);
+	p.cpool.BindNativeFunc("in_coroutine", natInCoroutine);
+	p.cpool.BindNativeFunc("arena_call", natArenaCall);
+
 	// hashers:
 	p.cpool.BindNativeFunc("__float::hash", natHashFloat);
 	p.cpool.BindNativeFunc("__double::hash", natHashDouble);
@@ -1,5 +1,6 @@
 #include "Builtin.h"
 #include <Lethe/Script/Program/ConstPool.h>
+#include <Lethe/Script/Program/HeapProfiler.h>
 #include "Vm.h"
 #include <Lethe/Script/Program/CompiledProgram.h>
 #include <Lethe/Script/TypeInfo/BaseObject.h>
@@ -363,8 +364,11 @@ Int Opcode_New_Internal(Stack &stk)
 
 	if (dt)
 	{
+		auto &ctx = stk.GetContext();
+		const bool arena = ctx.GetArenaDepth() > 0;
+
 		// FIXME: better
-		auto ptr = ObjectHeap::Get().Alloc(dt->size, dt->align, dt->classNameGroupKey);
+		auto ptr = arena ? ctx.AllocArenaObject(dt->size) : ObjectHeap::Get().Alloc(dt->size, dt->align, dt->classNameGroupKey);
 		MemSet(ptr, 0, dt->size);
 		::new(ptr) BaseObject;
 		stk.PushPtr(ptr);
@@ -372,7 +376,8 @@ Int Opcode_New_Internal(Stack &stk)
 		auto obj = static_cast<BaseObject *>(ptr);
 		// note: vtbl will be set externally
 		obj->strongRefCount = 0;
-		obj->weakRefCount = 1;
+		// arena holds an extra weak ref so that its memory never goes back to ObjectHeap
+		obj->weakRefCount = 1 + arena;
 		return dt->funCtor;
 	}
 
@@ -408,6 +413,22 @@ void Opcode_New(Stack &stk)
 	Opcode_New_Internal(stk);
 }
 
+// construct object in stack frame storage: [0] = name, [1] = ptr
+// the frame owns the only strong ref, so refcounts never drop to zero
+void Opcode_New_Inplace(Stack &stk)
+{
+	ULong nidx = stk.GetLong(0);
+	stk.Pop(Stack::NAME_WORDS);
+	Name n;
+	n.SetValue(nidx);
+
+	auto ptr = stk.GetPtr(0);
+	stk.Pop(1);
+
+	if (Opcode_New_Internal(stk, n, ptr) >= 0)
+		static_cast<BaseObject *>(ptr)->strongRefCount = 1;
+}
+
 void Builtin::Opcode_New_Dynamic(Stack &stk)
 {
 	Int funCtor = Opcode_New_Internal(stk);
@@ -444,21 +465,38 @@ void Builtin::Opcode_New_Dynamic(Stack &stk, Name n, void *inst)
 		stk.PushPtr(stk.GetProgram().instructions.GetData() + funCtor);
 }
 
-void Opcode_DecStrong(Stack &stk)
+void Builtin::Opcode_DecStrong(Stack &stk)
 {
 	auto obj = static_cast<BaseObject *>(stk.GetPtr(0));
 
-	if (obj)
-		stk.PushInt(Atomic::Decrement(obj->strongRefCount));
-	else
+	if (!obj)
+	{
 		stk.PushInt(1);
+		return;
+	}
+
+	auto res = RefAtomic::Decrement(obj->strongRefCount);
+
+	if (!res)
+	{
+		auto &ctx = stk.GetContext();
+
+		if (ctx.deferRelease)
+		{
+			// pretend it's still referenced; weak refs already see it as dead
+			ctx.deferredReleases.Add(obj);
+			res = 1;
+		}
+	}
+
+	stk.PushInt((Int)res);
 }
 
 void Opcode_TestWeakNull(Stack &stk)
 {
 	auto obj = static_cast<BaseObject *>(stk.GetPtr(0));
 
-	if (obj && !Atomic::Load(obj->strongRefCount))
+	if (obj && !RefAtomic::Load(obj->strongRefCount))
 		stk.SetPtr(0, nullptr);
 }
 
@@ -468,12 +506,12 @@ void Opcode_DecWeak(Stack &stk)
 
 	if (obj)
 	{
-		if (!Atomic::Decrement(obj->weakRefCount))
+		if (!RefAtomic::Decrement(obj->weakRefCount))
 		{
 			ObjectHeap::Get().Dealloc(obj);
 			stk.SetPtr(0, nullptr);
 		}
-		else if (!Atomic::Load(obj->strongRefCount))
+		else if (!RefAtomic::Load(obj->strongRefCount))
 		{
 			stk.SetPtr(0, nullptr);
 		}
@@ -484,8 +522,15 @@ void Opcode_StrongZero(Stack &stk)
 {
 	auto obj = static_cast<BaseObject *>(stk.GetPtr(0));
 
-	if (obj && !Atomic::Decrement(obj->weakRefCount))
-		ObjectHeap::Get().Dealloc(obj);
+	if (obj)
+	{
+		// only the header of a dead object is accessed through weak refs
+		if (RefAtomic::Load(obj->weakRefCount) > 1)
+			ObjectHeap::Get().Trim(obj, sizeof(BaseObject));
+
+		if (!RefAtomic::Decrement(obj->weakRefCount))
+			ObjectHeap::Get().Dealloc(obj);
+	}
 
 	stk.SetPtr(0, nullptr);
 }
@@ -495,7 +540,7 @@ void Builtin::Opcode_AddStrong(Stack &stk)
 	auto obj = static_cast<BaseObject *>(stk.GetPtr(0));
 
 	if (obj)
-		Atomic::Increment(obj->strongRefCount);
+		RefAtomic::Increment(obj->strongRefCount);
 }
 
 void Builtin::Opcode_AddStrongAfterNew(Stack &stk)
@@ -504,7 +549,7 @@ void Builtin::Opcode_AddStrongAfterNew(Stack &stk)
 
 	if (obj)
 	{
-		Atomic::Increment(obj->strongRefCount);
+		RefAtomic::Increment(obj->strongRefCount);
 		auto *ctype = obj->GetScriptClassType();
 
 		if (ctype)
@@ -517,7 +562,7 @@ void Opcode_AddWeak(Stack &stk)
 	auto obj = static_cast<BaseObject *>(stk.GetPtr(0));
 
 	if (obj)
-		Atomic::Increment(obj->weakRefCount);
+		RefAtomic::Increment(obj->weakRefCount);
 }
 
 void Opcode_AddWeakNull(Stack &stk)
@@ -526,10 +571,10 @@ void Opcode_AddWeakNull(Stack &stk)
 
 	if (obj)
 	{
-		if (!Atomic::Load(obj->strongRefCount))
+		if (!RefAtomic::Load(obj->strongRefCount))
 			stk.SetPtr(0, nullptr);
 		else
-			Atomic::Increment(obj->weakRefCount);
+			RefAtomic::Increment(obj->weakRefCount);
 	}
 }
 
@@ -573,7 +618,7 @@ void Opcode_FixWeak(Stack &stk)
 
 	auto obj = static_cast<BaseObject *>(stk.GetPtr(0));
 
-	if (obj && (!Atomic::Load(obj->strongRefCount) || !obj->GetScriptClassType()->IsA(n)))
+	if (obj && (!RefAtomic::Load(obj->strongRefCount) || !obj->GetScriptClassType()->IsA(n)))
 		stk.SetPtr(0, nullptr);
 }
 
@@ -582,11 +627,11 @@ void Opcode_FixWeakRef(Stack &stk)
 	auto pobj = static_cast<AtomicPointer<BaseObject>*>(stk.GetPtr(0));
 	auto *obj = pobj->Load();
 
-	if (!obj || Atomic::Load(obj->strongRefCount) != 0)
+	if (!obj || RefAtomic::Load(obj->strongRefCount) != 0)
 		return;
 
 	if (auto *tmp = pobj->Exchange(nullptr))
-		if (!Atomic::Decrement(tmp->weakRefCount))
+		if (!RefAtomic::Decrement(tmp->weakRefCount))
 			ObjectHeap::Get().Dealloc(tmp);
 }
 
@@ -600,10 +645,10 @@ void Opcode_FixAddWeak(Stack &stk)
 
 	if (obj)
 	{
-		if (!Atomic::Load(obj->strongRefCount) || !obj->GetScriptClassType()->IsA(n))
+		if (!RefAtomic::Load(obj->strongRefCount) || !obj->GetScriptClassType()->IsA(n))
 			stk.SetPtr(0, nullptr);
 		else
-			Atomic::Increment(obj->weakRefCount);
+			RefAtomic::Increment(obj->weakRefCount);
 	}
 }
 
@@ -632,7 +677,7 @@ void Opcode_FixAddStrong(Stack &stk)
 		if (!obj->GetScriptClassType()->IsA(n))
 			stk.SetPtr(0, nullptr);
 		else
-			Atomic::Increment(obj->strongRefCount);
+			RefAtomic::Increment(obj->strongRefCount);
 	}
 }
 
@@ -696,6 +741,41 @@ void Builtin::OpCode_ProfExit(Stack &stk)
 	stk.GetContext().ProfExit(offset);
 }
 
+void Builtin::OpCode_HeapProfNew(Stack &stk)
+{
+	// stack: [0] = site index, [1] = new object
+	auto site = stk.GetInt(0);
+	stk.Pop(1);
+
+	auto *hp = stk.GetConstantPool().heapProfiler;
+	auto *obj = static_cast<const BaseObject *>(stk.GetPtr(0));
+
+	if (!hp || !obj)
+		return;
+
+	auto *dt = obj->GetScriptClassType();
+
+	if (dt)
+		hp->OnAlloc(obj, dt, (Int)ObjectHeap::Get().GetBlockSize(obj, (size_t)dt->size), site);
+}
+
+void Builtin::OpCode_HeapProfFree(Stack &stk)
+{
+	// stack: [0] = object being destroyed
+	auto *hp = stk.GetConstantPool().heapProfiler;
+
+	if (hp)
+		hp->OnFree(stk.GetPtr(0));
+
+	stk.Pop(1);
+}
+
+const char *Builtin::OpCode_GrowStack(Stack &stk)
+{
+	// JIT stack check failed: requested words are passed via stack object
+	return stk.Grow((Int)stk.growRequest) ? nullptr : "stack overflow";
+}
+
 // 64-bit integer emulation
 void Opcode_PUSH_LCONST(Stack &stk)
 {
@@ -1319,7 +1399,7 @@ static const BuiltinTable BUILTIN_TABLE[] =
 	{ BUILTIN_NEW_DYNAMIC,		"*NEW_DYNAMIC",			Builtin::Opcode_New_Dynamic},
 	{ BUILTIN_DEC_WEAK,			"*DEC_WEAK",			Opcode_DecWeak			},
 	{ BUILTIN_TEST_WEAK_NULL,	"*TEST_WEAK_NULL",		Opcode_TestWeakNull		},
-	{ BUILTIN_DEC_STRONG,		"*DEC_STRONG",			Opcode_DecStrong		},
+	{ BUILTIN_DEC_STRONG,		"*DEC_STRONG",			Builtin::Opcode_DecStrong},
 	{ BUILTIN_STRONG_ZERO,		"*STRONG_ZERO",			Opcode_StrongZero		},
 	{ BUILTIN_ADD_WEAK,			"*ADD_WEAK",			Opcode_AddWeak			},
 	{ BUILTIN_ADD_WEAK_NULL,	"*ADD_WEAK_NULL",		Opcode_AddWeakNull		},
@@ -1359,10 +1439,10 @@ static const BuiltinTable BUILTIN_TABLE[] =
 	{ BUILTIN_LADD,             "*LADD",                Opcode_LADD             },
 	{ BUILTIN_LSUB,             "*LSUB",                Opcode_LSUB             },
 	{ BUILTIN_LMUL,             "*LMUL",                Opcode_LMUL             },
-	{ BUILTIN_LMOD,             "*LMOD",                (BuiltinCallback)(void *)Opcode_LMOD },
-	{ BUILTIN_ULMOD,            "*ULMOD",               (BuiltinCallback)(void *)Opcode_ULMOD },
-	{ BUILTIN_LDIV,             "*LDIV",                (BuiltinCallback)(void *)Opcode_LDIV },
-	{ BUILTIN_ULDIV,            "*ULDIV",               (BuiltinCallback)(void *)Opcode_ULDIV },
+	{ BUILTIN_LMOD,             "*LMOD",                ConstPool::FromTrap(Opcode_LMOD) },
+	{ BUILTIN_ULMOD,            "*ULMOD",               ConstPool::FromTrap(Opcode_ULMOD) },
+	{ BUILTIN_LDIV,             "*LDIV",                ConstPool::FromTrap(Opcode_LDIV) },
+	{ BUILTIN_ULDIV,            "*ULDIV",               ConstPool::FromTrap(Opcode_ULDIV) },
 	{ BUILTIN_LSAR,             "*LSAR",                Opcode_LSAR             },
 	{ BUILTIN_LSHR,             "*LSHR",                Opcode_LSHR             },
 	{ BUILTIN_LAND,             "*LAND",                Opcode_LAND             },
@@ -1421,6 +1501,13 @@ static const BuiltinTable BUILTIN_TABLE[] =
 
 	{ BUILTIN_MARK_STRUCT_DELEGATE, "*MARK_STR_DG",     Opcode_MarkStructDg     },
 
+	{ BUILTIN_NEW_INPLACE,       "*NEW_INPLACE",        Opcode_New_Inplace      },
+
+	{ BUILTIN_HEAP_PROF_NEW,     "*HEAP_PROF_NEW",      Builtin::OpCode_HeapProfNew },
+	{ BUILTIN_HEAP_PROF_FREE,    "*HEAP_PROF_FREE",     Builtin::OpCode_HeapProfFree },
+
+	{ BUILTIN_GROW_STACK,        "*GROW_STACK",         ConstPool::FromTrap(Builtin::OpCode_GrowStack) },
+
 	{ -1, 0, 0 }
 };
 
@@ -160,7 +160,14 @@ enum
 	BUILTIN_SLICEFWD_INPLACE,
 	BUILTIN_SLICEFWD,
 
-	BUILTIN_MARK_STRUCT_DELEGATE
+	BUILTIN_MARK_STRUCT_DELEGATE,
+
+	BUILTIN_NEW_INPLACE,
+
+	BUILTIN_HEAP_PROF_NEW,
+	BUILTIN_HEAP_PROF_FREE,
+
+	BUILTIN_GROW_STACK
 };
 
 class LETHE_API Builtin
@@ -168,9 +175,13 @@ class LETHE_API Builtin
 public:
 	static void OpCode_ProfEnter(Stack &stk);
 	static void OpCode_ProfExit(Stack &stk);
+	static void OpCode_HeapProfNew(Stack &stk);
+	static void OpCode_HeapProfFree(Stack &stk);
+	static const char *OpCode_GrowStack(Stack &stk);
 	static void Opcode_New_Dynamic(Stack &stk);
 	static void Opcode_New_Dynamic(Stack &stk, Name n, void *inst);
 	static void Opcode_AddStrong(Stack &stk);
+	static void Opcode_DecStrong(Stack &stk);
 	static void Opcode_AddStrongAfterNew(Stack &stk);
 };
 
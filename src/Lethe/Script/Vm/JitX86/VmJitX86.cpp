@@ -3018,8 +3018,13 @@ void VmJitX86::AddStrong()
 	EmitNew(0x74);
 	Int jmp = code.GetSize();
 	Emit(0);
+#ifdef LETHE_SINGLE_THREADED_REFS
+	// add dword [reg+ofs], sreg
+	Add(Mem32(reg + BaseObject::OFS_REFC), sreg);
+#else
 	// lock xadd dword [reg+ofs], sreg
 	XAdd(Mem32(reg + BaseObject::OFS_REFC), sreg);
+#endif
 	code[jmp] = Byte(code.GetSize() - jmp - 1);
 
 	Pop(1);
@@ -2240,14 +2240,23 @@ bool VmJitX86::CodeGenPass(CompiledProgram &prog, Int pass)
 
 			// lea eax, [edi+const]
 			Lea(Eax.ToRegPtr(), MemPtr(Edi - limit));
-			// [esi] = stack bottom
+			// [esi] = committed stack limit
 			// sub eax,[esi + ...]
 			Sub(Eax.ToRegPtr(), MemPtr(StackObjectPtr() + 2*Stack::WORD_SIZE));
-			// jae $+1
+			// jae skip
 			EmitNew(0x73);
-			Emit(0x01);
-			// int 3
-			Int3();
+			Emit(0);
+			Int skipAdr = code.GetSize();
+
+			// slow path: try to grow stack, traps on overflow
+			// mov eax,words; mov [esi + ...],eax
+			Mov(Eax, DecodeUImm24(ins));
+			Mov(MemPtr(StackObjectPtr() + 3*Stack::WORD_SIZE), Eax.ToRegPtr());
+			EmitNCall(BUILTIN_GROW_STACK, reinterpret_cast<void *>(cpool.nFunc[BUILTIN_GROW_STACK]), true, false, true);
+
+			Int skip = code.GetSize() - skipAdr;
+			LETHE_ASSERT(skip < 128);
+			code[skipAdr-1] = (Byte)skip;
 		}
 		break;
 
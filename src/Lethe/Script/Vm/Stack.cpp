@@ -1,12 +1,39 @@
 #include "Stack.h"
 
+#include <Lethe/Core/Memory/Heap.h>
+#include <Lethe/Core/Math/Templates.h>
+
 namespace lethe
 {
 
 // Stack
 
-Stack::Stack(Int size)
-	: thisPtr(nullptr)
+Stack::Stack(Int size, Int maxSize)
+	: cpool(nullptr)
+	, context(nullptr)
+	, insPtr(nullptr)
+	, programCounter(-1)
+	, nesting(0)
+	, breakExecution(0)
+{
+	maxSize = Max(size, maxSize);
+
+	const size_t guard = Heap::GetOSPageSize();
+	reserveSize = (size_t)(maxSize + 3)*WORD_SIZE + guard;
+	reserveBase = Heap::ReservePages(reserveSize);
+	LETHE_ASSERT(reserveBase);
+
+	auto *rbase = static_cast<Byte *>(reserveBase);
+	Init(reinterpret_cast<StackWord *>(rbase + guard), reinterpret_cast<StackWord *>(rbase + reserveSize));
+
+	// nothing committed yet
+	limit = top;
+	Grow(size);
+}
+
+Stack::Stack(void *mem, size_t bytes)
+	: reserveBase(nullptr)
+	, reserveSize(0)
 	, cpool(nullptr)
 	, context(nullptr)
 	, insPtr(nullptr)
@@ -14,13 +41,64 @@ Stack::Stack(Int size)
 	, nesting(0)
 	, breakExecution(0)
 {
-	stack.Resize(size + 3, 0);
-	top = stack.GetData() + size;
+	auto *start = reinterpret_cast<StackWord *>(((UIntPtr)mem + WORD_SIZE-1) & ~(UIntPtr)(WORD_SIZE-1));
+	auto *end = reinterpret_cast<StackWord *>(((UIntPtr)mem + bytes) & ~(UIntPtr)(WORD_SIZE-1));
+	Init(start, end);
+	limit = base;
+}
+
+void Stack::Init(StackWord *nbase, StackWord *end)
+{
+	thisPtr = nullptr;
+	growRequest = 0;
+	base = nbase;
+
+	top = end - 3;
 	// 16-byte align stack
 	PushAlign(16);
 	bottom = top;
 }
 
+Stack::~Stack()
+{
+	if (reserveBase)
+		Heap::ReleasePages(reserveBase, reserveSize);
+}
+
+bool Stack::Grow(Int words)
+{
+	auto *need = top - words;
+
+	if (need >= limit)
+		return true;
+
+	if (need < base)
+		return false;
+
+	// at least double committed size
+	auto *nlimit = Min(need, bottom - 2*GetCommittedSize());
+
+	if (nlimit < base)
+		nlimit = base;
+
+	const UIntPtr pmask = Heap::GetOSPageSize()-1;
+	nlimit = reinterpret_cast<StackWord *>((UIntPtr)nlimit & ~pmask);
+
+	// first commit also covers the few words above bottom
+	auto *climit = reinterpret_cast<StackWord *>(((UIntPtr)limit + pmask) & ~pmask);
+
+	if (climit > nlimit && !Heap::CommitPages(nlimit, (size_t)(climit - nlimit)*WORD_SIZE))
+		return false;
+
+	limit = nlimit;
+	return true;
+}
+
+bool Stack::CommitAll()
+{
+	return Grow(Int(top - base));
+}
+
 void Stack::PushStruct(Int align, Int sizeBytes)
 {
 	// word align
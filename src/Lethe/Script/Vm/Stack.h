@@ -4,6 +4,7 @@
 
 #include <Lethe/Core/Sys/Types.h>
 #include <Lethe/Core/Sys/Inline.h>
+#include <Lethe/Core/Sys/Likely.h>
 #include <Lethe/Core/String/String.h>
 
 namespace lethe
@@ -44,10 +45,19 @@ private:
 	StackWord *top;
 	// only one register here: this pointer
 	const void *thisPtr;
-	// return addresses is actually code indices
-	Array< StackWord > stack;
+	// lowest committed word; JIT reads this directly (slot 2)
+	StackWord *limit;
+	// words requested by JIT stack check (slot 3)
+	UIntPtr growRequest;
 	// bottom of stack
 	StackWord *bottom;
+	// lowest usable word (reserved range minus guard page)
+	StackWord *base;
+	// reserved range, null if external
+	void *reserveBase;
+	size_t reserveSize;
+
+	void Init(StackWord *nbase, StackWord *end);
 
 public:
 	enum Constants
@@ -62,7 +72,13 @@ public:
 	};
 
 	// default to 64k-entry stack (512kB in 64-bit mode, 256kB in 32-bit mode [this may change to 512kB in the future])
-	Stack(Int size = 64*1024);
+	// maxSize > size: reserve address space for maxSize words but commit only size words, stack grows on demand
+	// (doubling committed size) when a function entry check fails; contents never move
+	// there's always an inaccessible guard page below the reserved range
+	Stack(Int size = 64*1024, Int maxSize = 0);
+	// use external read-write memory (not owned), can't grow
+	Stack(void *mem, size_t bytes);
+	~Stack();
 
 	// align size up to stack word size
 	static inline Int AlignSize(Int size)
@@ -122,8 +138,16 @@ public:
 	inline void *GetThis();
 	inline void SetThis(const void *ptr);
 
-	// check if we can push this many words without overflow
-	inline bool Check(Int words) const;
+	// check if we can push this many words without overflow, grows stack if possible
+	inline bool Check(Int words);
+	// commit at least this many words below top; false = overflow
+	bool Grow(Int words);
+	// commit whole reserved range (needed when running without stack checks)
+	bool CommitAll();
+
+	// committed/reserved size in words
+	inline Int GetCommittedSize() const;
+	inline Int GetMaxSize() const;
 
 	// pop n stack words
 	inline void Pop(Int words);
@@ -145,7 +169,7 @@ public:
 
 	inline const StackWord *GetBase() const
 	{
-		return stack.GetData();
+		return base;
 	}
 
 	inline ScriptContext &GetContext() const
@@ -176,6 +200,7 @@ private:
 	friend class Vm;
 	friend class VmJitX86;
 	friend class ScriptContext;
+	friend class Builtin;
 
 	// FIXME: hack but necessary for some builtins
 	ConstPool *cpool;
@@ -391,9 +416,19 @@ inline void Stack::Pop(Int words)
 	top += words;
 }
 
-inline bool Stack::Check(Int words) const
+inline bool Stack::Check(Int words)
+{
+	return LETHE_LIKELY(top - limit >= words) || Grow(words);
+}
+
+inline Int Stack::GetCommittedSize() const
+{
+	return Int(bottom - limit);
+}
+
+inline Int Stack::GetMaxSize() const
 {
-	return top - stack.GetData() >= words;
+	return Int(bottom - base);
 }
 
 inline const void *Stack::GetThis() const
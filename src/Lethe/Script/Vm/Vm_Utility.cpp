@@ -377,7 +377,9 @@ String Vm::DisassembleInternal(Int pc, Int ins) const
 			return adr + String::Printf("%s %d (%s \"%s\")", d->name, ins >> 8, nativeName.Ansi(), sval.Ansi());
 		}
 
-		if (pc > 1 && nativeName == "*NEW" && prog->instructions[pc-1] == OPC_PUSH_LCONST && (prog->instructions[pc-2] & 255) == OPC_PUSH_ICONST)
+		const bool isNew = nativeName == "*NEW" || nativeName == "*NEW_INPLACE";
+
+		if (pc > 1 && isNew && prog->instructions[pc-1] == OPC_PUSH_LCONST && (prog->instructions[pc-2] & 255) == OPC_PUSH_ICONST)
 		{
 			Int sidx = Int((UInt)prog->instructions[pc-2] >> 8);
 			Name n;
@@ -385,7 +387,7 @@ String Vm::DisassembleInternal(Int pc, Int ins) const
 			return adr + String::Printf("%s %d (%s %s)", d->name, ins >> 8, nativeName.Ansi(), n.ToString().Ansi());
 		}
 
-		if (pc > 1 && nativeName == "*NEW" && prog->instructions[pc-1] == OPC_PUSHC_LCONST && (prog->instructions[pc-2] & 255) == OPC_PUSH_ICONST)
+		if (pc > 1 && isNew && prog->instructions[pc-1] == OPC_PUSHC_LCONST && (prog->instructions[pc-2] & 255) == OPC_PUSH_ICONST)
 		{
 			Int sidx = Int((UInt)prog->instructions[pc-2] >> 8);
 			Name n;